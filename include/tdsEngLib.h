@@ -9,12 +9,79 @@
 	Date		: March 13, 2004
 */
 
+#ifndef TDSENGLIB_H
+#define TDSENGLIB_H
+
+/* 64 bit integer used by the ...64 functions */
+#ifdef _HPUX_SOURCE
+	typedef long long tdsInt64;
+#else
+	typedef __int64 tdsInt64;
+#endif
+
+/* Handles returned by the ...Create functions.  Their contents are private to the DLL */
+typedef struct utcDateTimeFmt utcDateTimeFmt;
+typedef struct timeIndex timeIndex;
+typedef struct lscfAccum lscfAccum;
+typedef struct lscfRolling lscfRolling;
+typedef struct chanStats chanStats;
+typedef struct steadyDetect steadyDetect;
+typedef struct rollPercentile rollPercentile;
+typedef struct quantSketch quantSketch;
+typedef struct polyFunc polyFunc;
+
 #ifdef _HPUX_SOURCE
 	extern long  linearLSCF (double *xdata, double *ydata, long num, double *slope, double *intercept, double *corrCoef);
+	extern lscfAccum * linearLSCF_accCreate (void);
+	extern void  linearLSCF_accFree (lscfAccum *acc);
+	extern void  linearLSCF_accReset (lscfAccum *acc);
+	extern long  linearLSCF_accAdd (lscfAccum *acc, double x, double y);
+	extern long  linearLSCF_accAddArray (lscfAccum *acc, double *xdata, double *ydata, long num);
+	extern long  linearLSCF_accMerge (lscfAccum *dest, lscfAccum *acc1, lscfAccum *acc2);
+	extern long  linearLSCF_accResult (lscfAccum *acc, double *slope, double *intercept, double *corrCoef);
+	extern lscfRolling * linearLSCF_rollCreate (long window);
+	extern void  linearLSCF_rollFree (lscfRolling *roll);
+	extern long  linearLSCF_rollAdd (lscfRolling *roll, double x, double y, double *slope, double *intercept, double *corrCoef);
+	extern long  linearLSCF_rolling (double *xdata, double *ydata, long num, long window, double *slope, double *intercept, double *corrCoef);
+	extern long  linearLSCF_multi (double *xdata, double *ydata, long num, long numY, double *slope, double *intercept, double *corrCoef);
+	extern long  linearLSCF_par (double *xdata, double *ydata, long num, long nThreads, double *slope, double *intercept, double *corrCoef);
+	extern long  linearLSCF_weighted (double *xdata, double *ydata, double *wdata, long num, double *slope, double *intercept, double *corrCoef);
+	extern long  linearLSCF_weighted_multi (double *xdata, double *ydata, double *wdata, long num, long numY, double *slope, double *intercept, double *corrCoef);
+	extern long  corrMatrix (double *ydata, long num, long numY, long nThreads, double *corr);
+	extern long  theilSenSlope (double *xdata, double *ydata, long num, double *slope, double *intercept);
+	extern long  theilSenSlope_multi (double *xdata, double *ydata, long num, long numY, double *slope, double *intercept);
 	extern long  sortDoublePtr (double *fdata, long num, char how, long *index);
+	extern long  sortDoubleRadix (double *fdata, long num, char how, long *index);
+	extern long  sortDoubleRadix_i32 (double *fdata, long num, char how, int *index);
+	extern long  sortDoublePtr_par (double *fdata, long num, char how, long *index, long nThreads);
+	extern long  sortDoubleAdaptive (double *fdata, long num, char how, long *index);
+	extern long  selectNth (double *data, long num, long nth, double *value);
+	extern long  topK (double *data, long num, long kk, char how, long *index);
+	extern long  percentiles (double *data, long num, double *pct, long np, double *out);
+	extern long  permuteArrays (long *index, long num, double **arrays, long nArrays, double **out);
+	extern rollPercentile * rollPercentileCreate (long window, double pct);
+	extern void  rollPercentileFree (rollPercentile *rp);
+	extern long  rollPercentileAdd (rollPercentile *rp, double value, double *result);
+	extern long  rollPercentile_array (double *data, long num, long window, double pct, char how, double *out);
+	extern long  histogram_array (double *data, long num, double lowEdge, double highEdge, long numBins, double *counts);
+	extern long  histogramPercentile (double *counts, long numBins, double lowEdge, double highEdge, double *pct, long np, double *out);
+	extern quantSketch * quantSketchCreate (long k);
+	extern void  quantSketchFree (quantSketch *sk);
+	extern long  quantSketchAdd_array (quantSketch *sk, double *data, long num);
+	extern long  quantSketchMerge (quantSketch *dest, quantSketch *src);
+	extern long  quantSketchQuantile (quantSketch *sk, double *pct, long np, double *out, double *count);
+	extern long  quantSketchSerialize (quantSketch *sk, char *buffer, long bufSize, long *size);
+	extern quantSketch * quantSketchDeserialize (char *buffer, long size);
 
 	extern void  utcToLocalDateTimeStr (long UTCsec, char *dateStr, char *timeStr);
 	extern void  utcToLocalDateTimeStr2 (double fractionalUTCsec, char *dateStr, char *timeStr, long *millisec);
+	extern long  utcToLocalDateTime (long UTCsec, long *localDate, long *localTime);
+	extern long  utcToLocalDateTime_array (long *UTCsec, long num, long *localDate, long *localTime);
+	extern long  utcToLocalDateTime64_array (tdsInt64 *UTCsec, long num, long *localDate, long *localTime);
+	extern long  utcUsecToLocalDateTime64_array (tdsInt64 *UTCusec, long num, long *localDate, long *localTime, long *microsec);
+	extern utcDateTimeFmt * utcDateTimeFmtCreate (void);
+	extern void  utcDateTimeFmtFree (utcDateTimeFmt *fmt);
+	extern void  utcToLocalDateTimeStr2_fmt (utcDateTimeFmt *fmt, double fractionalUTCsec, char *dateStr, char *timeStr, long *millisec);
 
 	extern double  ctimeToDbl (char *timeString);
 	extern long  timeToDDDHHMMSS (double timeVal);
@@ -31,6 +98,18 @@
 	extern long  timeToStdStr (double timeVal, char *strout);
 	extern long  timeToCtime (double timeVal, char *strout);
 
+	extern timeIndex * timeIndexCreate (double *timeData, long num);
+	extern void  timeIndexFree (timeIndex *ti);
+	extern double  timeIndexElapsed (timeIndex *ti, long index);
+	extern long  timeIndexRange (timeIndex *ti, double t0, double t1, long *startIndex, long *endIndex, long maxRanges, long *numRanges);
+	extern steadyDetect * steadyDetectCreate (double windowSec, double maxSlope, double maxSpread);
+	extern void  steadyDetectFree (steadyDetect *sd);
+	extern void  steadyDetectReset (steadyDetect *sd);
+	extern long  steadyDetectAdd (steadyDetect *sd, double timeVal, double value, double *slope, double *spread, long *changed);
+	extern long  steadyDetectLastChange (steadyDetect *sd, double *timeVal, char *timeStr, double *steadySec);
+	extern long  steadyDetect_array (double *timeData, double *valueData, long num, double windowSec, double maxSlope, double maxSpread, long *state, long maxTrans, long *transIndex, long *numTrans);
+	extern long  rateOfChange_array (double *timeData, double *valueData, long num, char mode, long halfWidth, double *dydt);
+
 	extern double  tck_V32toF (double volts);
 	extern double  tck_FtoV32 (double temp);
 	extern double  tck_VtoF (double volts, double refTemp);
@@ -62,6 +141,13 @@
 	extern double  tct_V32toF (double volts);
 	extern double  tct_FtoV32 (double temp);
 	extern double  tct_VtoF (double volts, double refTemp);
+	extern chanStats * chanStatsCreate (double lowLimit, double highLimit);
+	extern void  chanStatsFree (chanStats *stats);
+	extern void  chanStatsReset (chanStats *stats);
+	extern long  chanStatsAddArray (chanStats *stats, double *data, long num);
+	extern long  chanStatsMerge (chanStats *dest, chanStats *stats1, chanStats *stats2);
+	extern long  chanStatsResult (chanStats *stats, double *count, double *mean, double *stdDev, double *sumSq, double *minVal, double *minIndex, double *maxVal, double *maxIndex, double *numBelow, double *numAbove);
+	extern long  tcV32toF_array (char tcType, double *volts, long num, double *tempF, chanStats *stats);
 
 	extern double  rtd_PTgenA385_OhmToC2 (double resistanceInOhms, double refResistanceInOhms);
 	extern double  rtd_PTgen_OhmToC (double resistanceInOhms, double R0, double A, double B, double C);
@@ -88,13 +174,68 @@
 	extern double  rtd_PT1000A385_FtoOhm (double tempInDegF);
 
 	double polyValue (double *coef, double xval, long order);
+	extern double  polyValueInv (double *coef, double xval, long order);
+	extern long  polyValue_array (double *coef, long order, double *xdata, double *ydata, long num);
+	extern polyFunc * polyFuncCreate (double *coef, long order);
+	extern void  polyFuncFree (polyFunc *pf);
+	extern double  polyFuncValue (polyFunc *pf, double xval);
+	extern long  polyFuncValue_array (polyFunc *pf, double *xdata, double *ydata, long num);
+	extern long  polyFit (double *xdata, double *ydata, long num, long order, double *coef, double *rms);
+	extern long  polyFit_multi (double *xdata, double *ydata, long num, long numY, long order, double *coef, double *rms);
 	long linearLookup (double *xdata, double *ydata, double xval, double *yval, long numData);
+	extern long  resampleChannels (double **timeData, double **valueData, long *numData, long numChannels, double startTime, double stepSec, long numGrid, char how, double fillValue, double **outData);
 #else
 	extern long __cdecl linearLSCF (double *xdata, double *ydata, long num, double *slope, double *intercept, double *corrCoef);
+	extern lscfAccum * __cdecl linearLSCF_accCreate (void);
+	extern void __cdecl linearLSCF_accFree (lscfAccum *acc);
+	extern void __cdecl linearLSCF_accReset (lscfAccum *acc);
+	extern long __cdecl linearLSCF_accAdd (lscfAccum *acc, double x, double y);
+	extern long __cdecl linearLSCF_accAddArray (lscfAccum *acc, double *xdata, double *ydata, long num);
+	extern long __cdecl linearLSCF_accMerge (lscfAccum *dest, lscfAccum *acc1, lscfAccum *acc2);
+	extern long __cdecl linearLSCF_accResult (lscfAccum *acc, double *slope, double *intercept, double *corrCoef);
+	extern lscfRolling * __cdecl linearLSCF_rollCreate (long window);
+	extern void __cdecl linearLSCF_rollFree (lscfRolling *roll);
+	extern long __cdecl linearLSCF_rollAdd (lscfRolling *roll, double x, double y, double *slope, double *intercept, double *corrCoef);
+	extern long __cdecl linearLSCF_rolling (double *xdata, double *ydata, long num, long window, double *slope, double *intercept, double *corrCoef);
+	extern long __cdecl linearLSCF_multi (double *xdata, double *ydata, long num, long numY, double *slope, double *intercept, double *corrCoef);
+	extern long __cdecl linearLSCF_par (double *xdata, double *ydata, long num, long nThreads, double *slope, double *intercept, double *corrCoef);
+	extern long __cdecl linearLSCF_weighted (double *xdata, double *ydata, double *wdata, long num, double *slope, double *intercept, double *corrCoef);
+	extern long __cdecl linearLSCF_weighted_multi (double *xdata, double *ydata, double *wdata, long num, long numY, double *slope, double *intercept, double *corrCoef);
+	extern long __cdecl corrMatrix (double *ydata, long num, long numY, long nThreads, double *corr);
+	extern long __cdecl theilSenSlope (double *xdata, double *ydata, long num, double *slope, double *intercept);
+	extern long __cdecl theilSenSlope_multi (double *xdata, double *ydata, long num, long numY, double *slope, double *intercept);
 	extern long __cdecl sortDoublePtr (double *fdata, long num, char how, long *index);
+	extern long __cdecl sortDoubleRadix (double *fdata, long num, char how, long *index);
+	extern long __cdecl sortDoubleRadix_i32 (double *fdata, long num, char how, int *index);
+	extern long __cdecl sortDoublePtr_par (double *fdata, long num, char how, long *index, long nThreads);
+	extern long __cdecl sortDoubleAdaptive (double *fdata, long num, char how, long *index);
+	extern long __cdecl selectNth (double *data, long num, long nth, double *value);
+	extern long __cdecl topK (double *data, long num, long kk, char how, long *index);
+	extern long __cdecl percentiles (double *data, long num, double *pct, long np, double *out);
+	extern long __cdecl permuteArrays (long *index, long num, double **arrays, long nArrays, double **out);
+	extern rollPercentile * __cdecl rollPercentileCreate (long window, double pct);
+	extern void __cdecl rollPercentileFree (rollPercentile *rp);
+	extern long __cdecl rollPercentileAdd (rollPercentile *rp, double value, double *result);
+	extern long __cdecl rollPercentile_array (double *data, long num, long window, double pct, char how, double *out);
+	extern long __cdecl histogram_array (double *data, long num, double lowEdge, double highEdge, long numBins, double *counts);
+	extern long __cdecl histogramPercentile (double *counts, long numBins, double lowEdge, double highEdge, double *pct, long np, double *out);
+	extern quantSketch * __cdecl quantSketchCreate (long k);
+	extern void __cdecl quantSketchFree (quantSketch *sk);
+	extern long __cdecl quantSketchAdd_array (quantSketch *sk, double *data, long num);
+	extern long __cdecl quantSketchMerge (quantSketch *dest, quantSketch *src);
+	extern long __cdecl quantSketchQuantile (quantSketch *sk, double *pct, long np, double *out, double *count);
+	extern long __cdecl quantSketchSerialize (quantSketch *sk, char *buffer, long bufSize, long *size);
+	extern quantSketch * __cdecl quantSketchDeserialize (char *buffer, long size);
 
 	extern void __cdecl utcToLocalDateTimeStr (long UTCsec, char *dateStr, char *timeStr);
 	extern void __cdecl utcToLocalDateTimeStr2 (double fractionalUTCsec, char *dateStr, char *timeStr, long *millisec);
+	extern long __cdecl utcToLocalDateTime (long UTCsec, long *localDate, long *localTime);
+	extern long __cdecl utcToLocalDateTime_array (long *UTCsec, long num, long *localDate, long *localTime);
+	extern long __cdecl utcToLocalDateTime64_array (tdsInt64 *UTCsec, long num, long *localDate, long *localTime);
+	extern long __cdecl utcUsecToLocalDateTime64_array (tdsInt64 *UTCusec, long num, long *localDate, long *localTime, long *microsec);
+	extern utcDateTimeFmt * __cdecl utcDateTimeFmtCreate (void);
+	extern void __cdecl utcDateTimeFmtFree (utcDateTimeFmt *fmt);
+	extern void __cdecl utcToLocalDateTimeStr2_fmt (utcDateTimeFmt *fmt, double fractionalUTCsec, char *dateStr, char *timeStr, long *millisec);
 
 	extern double __cdecl ctimeToDbl (char *timeString);
 	extern long __cdecl timeToDDDHHMMSS (double timeVal);
@@ -111,6 +252,18 @@
 	extern long __cdecl timeToStdStr (double timeVal, char *strout);
 	extern long __cdecl timeToCtime (double timeVal, char *strout);
 
+	extern timeIndex * __cdecl timeIndexCreate (double *timeData, long num);
+	extern void __cdecl timeIndexFree (timeIndex *ti);
+	extern double __cdecl timeIndexElapsed (timeIndex *ti, long index);
+	extern long __cdecl timeIndexRange (timeIndex *ti, double t0, double t1, long *startIndex, long *endIndex, long maxRanges, long *numRanges);
+	extern steadyDetect * __cdecl steadyDetectCreate (double windowSec, double maxSlope, double maxSpread);
+	extern void __cdecl steadyDetectFree (steadyDetect *sd);
+	extern void __cdecl steadyDetectReset (steadyDetect *sd);
+	extern long __cdecl steadyDetectAdd (steadyDetect *sd, double timeVal, double value, double *slope, double *spread, long *changed);
+	extern long __cdecl steadyDetectLastChange (steadyDetect *sd, double *timeVal, char *timeStr, double *steadySec);
+	extern long __cdecl steadyDetect_array (double *timeData, double *valueData, long num, double windowSec, double maxSlope, double maxSpread, long *state, long maxTrans, long *transIndex, long *numTrans);
+	extern long __cdecl rateOfChange_array (double *timeData, double *valueData, long num, char mode, long halfWidth, double *dydt);
+
 	extern double __cdecl tck_V32toF (double volts);
 	extern double __cdecl tck_FtoV32 (double temp);
 	extern double __cdecl tck_VtoF (double volts, double refTemp);
@@ -142,6 +295,13 @@
 	extern double __cdecl tct_V32toF (double volts);
 	extern double __cdecl tct_FtoV32 (double temp);
 	extern double __cdecl tct_VtoF (double volts, double refTemp);
+	extern chanStats * __cdecl chanStatsCreate (double lowLimit, double highLimit);
+	extern void __cdecl chanStatsFree (chanStats *stats);
+	extern void __cdecl chanStatsReset (chanStats *stats);
+	extern long __cdecl chanStatsAddArray (chanStats *stats, double *data, long num);
+	extern long __cdecl chanStatsMerge (chanStats *dest, chanStats *stats1, chanStats *stats2);
+	extern long __cdecl chanStatsResult (chanStats *stats, double *count, double *mean, double *stdDev, double *sumSq, double *minVal, double *minIndex, double *maxVal, double *maxIndex, double *numBelow, double *numAbove);
+	extern long __cdecl tcV32toF_array (char tcType, double *volts, long num, double *tempF, chanStats *stats);
 
 	extern double __cdecl rtd_PTgenA385_OhmToC2 (double resistanceInOhms, double refResistanceInOhms);
 	extern double __cdecl rtd_PTgen_OhmToC (double resistanceInOhms, double R0, double A, double B, double C);
@@ -168,5 +328,16 @@
 	extern double __cdecl rtd_PT1000A385_FtoOhm (double tempInDegF);
 
 	extern double __cdecl polyValue (double *coef, double xval, long order);
+	extern double __cdecl polyValueInv (double *coef, double xval, long order);
+	extern long __cdecl polyValue_array (double *coef, long order, double *xdata, double *ydata, long num);
+	extern polyFunc * __cdecl polyFuncCreate (double *coef, long order);
+	extern void __cdecl polyFuncFree (polyFunc *pf);
+	extern double __cdecl polyFuncValue (polyFunc *pf, double xval);
+	extern long __cdecl polyFuncValue_array (polyFunc *pf, double *xdata, double *ydata, long num);
+	extern long __cdecl polyFit (double *xdata, double *ydata, long num, long order, double *coef, double *rms);
+	extern long __cdecl polyFit_multi (double *xdata, double *ydata, long num, long numY, long order, double *coef, double *rms);
 	extern long __cdecl linearLookup (double *xdata, double *ydata, double xval, double *yval, long numData);
+	extern long __cdecl resampleChannels (double **timeData, double **valueData, long *numData, long numChannels, double startTime, double stepSec, long numGrid, char how, double fillValue, double **outData);
+#endif
+
 #endif
@@ -35,6 +35,87 @@
 /*				Had to define it explicitly in the source	*/
 /*				tdsEng.c file								*/
 /*				Nuri Cankurt  October 15, 2012				*/
+/*		3.30	Added cached, thread-safe UTC to local		*/
+/*				time engine: utcToLocalDateTime and			*/
+/*				utcToLocalDateTime_array.  localtime()		*/
+/*				is no longer called per conversion			*/
+/*				October 18, 2026							*/
+/*		3.31	Added utcToLocalDateTimeStr2_fmt for		*/
+/*				incremental formatting of time ordered		*/
+/*				UTC streams									*/
+/*				October 18, 2026							*/
+/*		3.32	Added 64 bit UTC seconds/microseconds		*/
+/*				batch conversion for dates after 2038		*/
+/*				October 18, 2026							*/
+/*		3.33	Added timeIndex functions for time			*/
+/*				window queries on DDDHHMMSSsss arrays		*/
+/*				October 18, 2026							*/
+/*		3.34	Added resampleChannels to align				*/
+/*				irregularly sampled channels on one grid	*/
+/*				October 18, 2026							*/
+/*		3.35	Added streaming, mergeable least square		*/
+/*				fit accumulator linearLSCF_acc...			*/
+/*				October 18, 2026							*/
+/*		3.36	Added rolling window least square fit		*/
+/*				linearLSCF_roll... and linearLSCF_rolling	*/
+/*				October 18, 2026							*/
+/*		3.37	Added linearLSCF_multi for many channels	*/
+/*				against one x vector						*/
+/*				October 18, 2026							*/
+/*		3.38	Added multithreaded, deterministic			*/
+/*				linearLSCF_par								*/
+/*				October 18, 2026							*/
+/*		3.39	Added polyFit and polyFit_multi least		*/
+/*				square fits for polyValue coefficients		*/
+/*				October 18, 2026							*/
+/*		3.40	Added linearLSCF_weighted and Theil-Sen		*/
+/*				robust fit theilSenSlope, with _multi		*/
+/*				variants									*/
+/*				October 18, 2026							*/
+/*		3.41	Added corrMatrix, blocked multithreaded		*/
+/*				correlation matrix of many channels			*/
+/*				October 18, 2026							*/
+/*		3.42	Added chanStats one pass statistics			*/
+/*				accumulator and tcV32toF_array batch		*/
+/*				conversion with optional statistics			*/
+/*				October 18, 2026							*/
+/*		3.43	Added steadyDetect streaming steady			*/
+/*				state detector and steadyDetect_array		*/
+/*				October 18, 2026							*/
+/*		3.44	Added rateOfChange_array derivative			*/
+/*				of time stamped channels					*/
+/*				October 18, 2026							*/
+/*		3.45	Added sortDoubleRadix and					*/
+/*				sortDoubleRadix_i32 radix argsorts			*/
+/*				October 18, 2026							*/
+/*		3.46	Added sortDoublePtr_par multithreaded		*/
+/*				stable merge argsort						*/
+/*				October 18, 2026							*/
+/*		3.47	Added sortDoubleAdaptive run detecting		*/
+/*				argsort, used by resampleChannels			*/
+/*				October 18, 2026							*/
+/*		3.48	Added selectNth, topK and percentiles		*/
+/*				selection without a full sort				*/
+/*				October 18, 2026							*/
+/*		3.49	Added permuteArrays tiled and in place		*/
+/*				permutation of companion arrays				*/
+/*				October 18, 2026							*/
+/*		3.50	Added rollPercentile rolling median and		*/
+/*				percentile filter							*/
+/*				October 18, 2026							*/
+/*		3.51	Added histogram_array, histogramPercentile	*/
+/*				and the quantSketch KLL quantile sketch		*/
+/*				October 18, 2026							*/
+/*		3.52	Added polyValue_array, Horner evaluation	*/
+/*				of many x values							*/
+/*				October 18, 2026							*/
+/*		3.53	Added polyFunc handle with order			*/
+/*				specialized unrolled kernels				*/
+/*				October 18, 2026							*/
+/*		3.54	Added polyValueInv, one division inverse	*/
+/*				power polynomial; used by polyValue_array	*/
+/*				and polyFunc for negative orders			*/
+/*				October 18, 2026							*/
 /************************************************************/
 
 #define _USE_32BIT_TIME_T	// Nuri Cankurt 10-15-2012
@@ -42,8 +123,11 @@
 #include <stdio.h> 
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <errno.h>
 #ifdef _HPUX_SOURCE
+	#include <pthread.h>
+	#include <unistd.h>
 #else
 	#include <io.h>
 	#include <windows.h>
@@ -59,39 +143,305 @@ long error;
 
 /************************************************************************/
 /*																		*/
-/* utcToLocalDateTimeStr: This function returns local date (mm/dd/yyyy) */
-/*		and local time (hh:mm:ss) as string from UTC seconds given		*/
+/* Local time zone engine used by the utcToLocal* functions.			*/
 /*																		*/
-/* If UTC seconds is in error, date and time strings are set to NULL	*/
+/* The first conversion builds a table of UTC offsets for the local		*/
+/* time zone by probing the C library once from 1970 to the end of		*/
+/* time_t (2038 for 32 bit time_t, 2199 for 64 bit time_t).  Each		*/
+/* entry holds the UTC second at which an offset (standard or daylight	*/
+/* saving time) starts.  After that a conversion is a binary search in	*/
+/* the table plus integer calendar arithmetic, so no static buffer		*/
+/* from localtime() is shared between threads.  The table is built		*/
+/* only once per process; later changes to the TZ setting are not seen.	*/
+/*																		*/
+/* All seconds are handled as 64 bit integers (tdsInt64), independent	*/
+/* of the size of time_t, so dates after 2038 work on every platform.	*/
 /************************************************************************/
 #ifdef _HPUX_SOURCE
-	void utcToLocalDateTimeStr (long UTCsec, char *dateStr, char *timeStr)
+	typedef long long tdsInt64;		/* same as in tdsEngLib.h */
+	typedef unsigned long long tdsUInt64;
 #else
-	DllExport void __cdecl utcToLocalDateTimeStr (long UTCsec, char *dateStr, char *timeStr)
+	typedef __int64 tdsInt64;
+	typedef unsigned __int64 tdsUInt64;
+#endif
+
+#define TZ_MAX_TRANS	2048
+#define TZ_PROBE_STEP	43200		/* 12 hours, less than any DST period */
+#define TZ_LAST_SEC32	2147483647	/* last second of 32 bit time_t (2038) */
+#define TZ_LAST_YEAR64	2199		/* table end when time_t is 64 bit */
+
+static tdsInt64 tzTransUtc[TZ_MAX_TRANS];	/* UTC second where offset starts */
+static long tzTransOffset[TZ_MAX_TRANS];	/* local - UTC in seconds */
+static long tzNumTrans;
+static tdsInt64 tzTableEnd;					/* first UTC second not covered */
+static long tzLastFullYear;					/* last year fully inside of the table */
+
+#ifdef _HPUX_SOURCE
+	static pthread_once_t tzTableOnce = PTHREAD_ONCE_INIT;
+#else
+	static volatile LONG tzTableState = 0;	/* 0=none, 1=building, 2=ready */
 #endif
+
+/* days since 1970-01-01 for a proleptic Gregorian date */
+static tdsInt64 daysFromCivil (long year, long month, long day)
 {
-	const	time_t *timer;
-	const struct tm *timeptr;
+	tdsInt64 yy, era, yoe, doy, doe;
 
-	if (UTCsec <=0)
+	yy=(tdsInt64)year - (month <= 2);
+	era=(yy >= 0 ? yy : yy-399)/400;
+	yoe=yy - era*400;
+	doy=(153*(month > 2 ? month-3 : month+9) + 2)/5 + day-1;
+	doe=yoe*365 + yoe/4 - yoe/100 + doy;
+
+	return era*146097 + doe - 719468;
+}
+
+/* proleptic Gregorian date for days since 1970-01-01 */
+static void civilFromDays (tdsInt64 days, long *year, long *month, long *day)
+{
+	tdsInt64 zz, era, doe, yoe, doy, mp;
+
+	zz=days + 719468;
+	era=(zz >= 0 ? zz : zz-146096)/146097;
+	doe=zz - era*146097;
+	yoe=(doe - doe/1460 + doe/36524 - doe/146096)/365;
+	doy=doe - (365*yoe + yoe/4 - yoe/100);
+	mp=(5*doy + 2)/153;
+
+	*day=(long)(doy - (153*mp + 2)/5 + 1);
+	*month=(long)(mp < 10 ? mp+3 : mp-9);
+	*year=(long)(yoe + era*400 + (*month <= 2));
+}
+
+/* splits seconds since 1970 into days and seconds of day (floor division) */
+static tdsInt64 splitDaySeconds (tdsInt64 secs, long *secOfDay)
+{
+	tdsInt64 days;
+
+	days=secs/86400;
+	if (secs - days*86400 < 0) days--;
+	*secOfDay=(long)(secs - days*86400);
+
+	return days;
+}
+
+/* asks the C library for the local offset at 't'.  Returns -1 if it cannot */
+static long tzProbeOffset (tdsInt64 utc, long *offset)
+{
+	time_t t;
+	struct tm tmv;
+	tdsInt64 local;
+
+	t=(time_t)utc;
+#ifdef _HPUX_SOURCE
+	if (localtime_r(&t,&tmv) == NULL)return -1;
+#else
+	if (localtime_s(&tmv,&t) != 0)return -1;
+#endif
+
+	local=daysFromCivil(tmv.tm_year+1900,tmv.tm_mon+1,tmv.tm_mday)*86400
+		+ tmv.tm_hour*3600 + tmv.tm_min*60 + tmv.tm_sec;
+	*offset=(long)(local - utc);
+
+	return 0;
+}
+
+static void tzBuildTable (void)
+{
+	tdsInt64 tt, next, lo, hi, mid, lastSec;
+	long off, offNext, offMid, year, month, day, secOfDay;
+
+	tzNumTrans=0;
+	tzTableEnd=0;
+	tzLastFullYear=0;
+
+	lastSec=TZ_LAST_SEC32;
+	if (sizeof(time_t) > 4) lastSec=daysFromCivil(TZ_LAST_YEAR64+1,1,1)*86400 - 1;
+
+	if (tzProbeOffset(0,&off) != 0)return;
+
+	tzTransUtc[0]=0;
+	tzTransOffset[0]=off;
+	tzNumTrans=1;
+
+	tt=0;
+	while (tt < lastSec)
 	{
-		strcpy(dateStr,"");
-		strcpy(timeStr,"");
+		next=tt + TZ_PROBE_STEP;
+		if (next > lastSec)next=lastSec;
+
+		if (tzProbeOffset(next,&offNext) != 0)break;
+
+		if (offNext == off)
+		{
+			tt=next;
+			continue;
+		}
+
+		/* offset changed somewhere in (tt, next]: find the exact second */
+		lo=tt;
+		hi=next;
+		while (hi - lo > 1)
+		{
+			mid=lo + (hi - lo)/2;
+			if (tzProbeOffset(mid,&offMid) != 0)break;
+			if (offMid == off) lo=mid;
+			else hi=mid;
+		}
+		if (tzProbeOffset(hi,&offMid) != 0)break;
+
+		if (tzNumTrans >= TZ_MAX_TRANS)break;
+		tzTransUtc[tzNumTrans]=hi;
+		tzTransOffset[tzNumTrans]=offMid;
+		tzNumTrans++;
+
+		tt=hi;
+		off=offMid;
+	}
+
+	tzTableEnd=tt + 1;
+
+	civilFromDays(splitDaySeconds(tzTableEnd,&secOfDay),&year,&month,&day);
+	tzLastFullYear=year - 1;
+}
+
+static void tzEnsureTable (void)
+{
+#ifdef _HPUX_SOURCE
+	pthread_once(&tzTableOnce,tzBuildTable);
+#else
+	if (tzTableState == 2)return;
+
+	if (InterlockedCompareExchange(&tzTableState,1,0) == 0)
+	{
+		tzBuildTable();
+		InterlockedExchange(&tzTableState,2);
 		return;
 	}
+	while (tzTableState != 2)Sleep(0);
+#endif
+}
+
+/* table search for tzLookup, 'utc' must be inside of the table */
+static long tzLookupTable (tdsInt64 utc, long hint, long *offset, tdsInt64 *validFrom, tdsInt64 *validTo)
+{
+	long lo, hi, mid;
+
+	if (tzNumTrans < 1 || utc < 0 || utc >= tzTableEnd)return -1;
+
+	if (hint >= 0 && hint < tzNumTrans && tzTransUtc[hint] <= utc
+		&& (hint == tzNumTrans-1 || utc < tzTransUtc[hint+1]))
+	{
+		lo=hint;
+	}
+	else
+	{
+		lo=0;
+		hi=tzNumTrans-1;
+		while (lo < hi)
+		{
+			mid=(lo + hi + 1)/2;
+			if (tzTransUtc[mid] <= utc) lo=mid;
+			else hi=mid-1;
+		}
+	}
+
+	*offset=tzTransOffset[lo];
+	if (validFrom != NULL) *validFrom=tzTransUtc[lo];
+	if (validTo != NULL) *validTo=(lo == tzNumTrans-1) ? tzTableEnd : tzTransUtc[lo+1];
+
+	return lo;
+}
+
+/*	Finds the local offset for 'utc'.  'hint' is the table entry found by the
+	previous call (or -1), which makes monotone streams O(1).  validFrom and
+	validTo (exclusive) bound the UTC seconds that share the same offset.
+
+	Seconds past the end of the table use the offsets of an equivalent year
+	inside the table, one that has the same number of days and starts on the
+	same weekday, so the DST rules in force at the end of the table carry on.
+
+	Returns table entry, or -1 if 'utc' is before 1970 or no table exists	*/
+static long tzLookup (tdsInt64 utc, long hint, long *offset, tdsInt64 *validFrom, tdsInt64 *validTo)
+{
+	long year, month, day, secOfDay, equivYear, entry;
+	tdsInt64 yearStart, nextYearStart, equivStart, shift, from, to;
+
+	tzEnsureTable();
+
+	if (utc < tzTableEnd)return tzLookupTable(utc,hint,offset,validFrom,validTo);
+	if (tzNumTrans < 1)return -1;
+
+	civilFromDays(splitDaySeconds(utc,&secOfDay),&year,&month,&day);
+	yearStart=daysFromCivil(year,1,1);
+	nextYearStart=daysFromCivil(year+1,1,1);
+
+	for (equivYear=tzLastFullYear;equivYear>tzLastFullYear-28;equivYear--)
+	{
+		equivStart=daysFromCivil(equivYear,1,1);
+		if (daysFromCivil(equivYear+1,1,1) - equivStart != nextYearStart - yearStart)continue;
+		if ((equivStart - yearStart)%7 == 0)break;
+	}
+	if (equivYear == tzLastFullYear-28)return -1;
+
+	shift=(equivStart - yearStart)*86400;
+	entry=tzLookupTable(utc + shift,hint,offset,&from,&to);
+	if (entry < 0)return -1;
+
+	from=from - shift;
+	to=to - shift;
+	if (from < yearStart*86400) from=yearStart*86400;
+	if (to > nextYearStart*86400) to=nextYearStart*86400;
+	if (validFrom != NULL) *validFrom=from;
+	if (validTo != NULL) *validTo=to;
+
+	return entry;
+}
+
+/* local date as yyyymmdd and local time as hhmmss for 'utc'.  Returns table entry or -1 */
+static long tzLocalDateTime (tdsInt64 utc, long hint, long *localDate, long *localTime)
+{
+	long entry, offset, secOfDay, year, month, day;
+	tdsInt64 days;
+
+	entry=tzLookup(utc,hint,&offset,NULL,NULL);
+	if (entry < 0)return -1;
+
+	days=splitDaySeconds(utc + offset,&secOfDay);
+	civilFromDays(days,&year,&month,&day);
 
-	timer = (const time_t *)&UTCsec;
-	timeptr = localtime(timer);
+	*localDate=year*10000 + month*100 + day;
+	*localTime=(secOfDay/3600)*10000 + ((secOfDay/60)%60)*100 + secOfDay%60;
 
-	if (timeptr == NULL)
+	return entry;
+}
+
+/************************************************************************/
+/*																		*/
+/* utcToLocalDateTimeStr: This function returns local date (mm/dd/yyyy) */
+/*		and local time (hh:mm:ss) as string from UTC seconds given		*/
+/*																		*/
+/* If UTC seconds is in error, date and time strings are set to NULL	*/
+/*																		*/
+/* Uses the cached local time zone table, so it is thread safe			*/
+/************************************************************************/
+#ifdef _HPUX_SOURCE
+	void utcToLocalDateTimeStr (long UTCsec, char *dateStr, char *timeStr)
+#else
+	DllExport void __cdecl utcToLocalDateTimeStr (long UTCsec, char *dateStr, char *timeStr)
+#endif
+{
+	long localDate, localTime;
+
+	if (UTCsec <=0 || tzLocalDateTime((tdsInt64)UTCsec,-1,&localDate,&localTime) < 0)
 	{
 		strcpy(dateStr,"");
 		strcpy(timeStr,"");
 		return;
 	} 
 
-	sprintf(dateStr,"%02d/%02d/%04d\0",(long) timeptr->tm_mon+1,(long) timeptr->tm_mday,(long) timeptr->tm_year+1900);
-	sprintf(timeStr,"%02d:%02d:%02d\0",(long) timeptr->tm_hour,(long) timeptr->tm_min,(long) timeptr->tm_sec);
+	sprintf(dateStr,"%02ld/%02ld/%04ld",(localDate/100)%100,localDate%100,localDate/10000);
+	sprintf(timeStr,"%02ld:%02ld:%02ld",localTime/10000,(localTime/100)%100,localTime%100);
 
 	return;
 }
@@ -131,184 +481,4595 @@ long error;
 	return;
 }
 
-/********************************************************************/
-/*                                                                  */
-/* linearLSCF: This function performs linear least square curve fit.*/
-/* and returns slope, intercept and correlation coef				*/
-/* Calling parameters:												*/
-/*   xdata=vector containing independent variable data				*/
-/*   ydata=vector containing dependent variable data				*/
-/*   num=number of data points in xdata (and in ydata)				*/
-/*																	*/
-/* Returned parameters:												*/
-/*   slope=slope of Y=aX + B (slope=a)								*/
-/*   intercept=intercept of Y=aX + B (intercept=B)					*/
-/*   corrCoef=Correlation coefficient R								*/
-/*																	*/
-/* Function returns zero if no error, -1 if error					*/
-/********************************************************************/
+/************************************************************************/
+/*																		*/
+/* utcToLocalDateTime: This function converts UTC seconds to local date	*/
+/*		as yyyymmdd and local time as hhmmss							*/
+/*		(i.e. 20120315 and 134502 for 03/15/2012 13:45:02)				*/
+/*																		*/
+/* This function is thread safe.  It does not call localtime()			*/
+/*																		*/
+/* Function returns 0 if no error, -1 if UTC seconds is in error		*/
+/*		(localDate and localTime are set to 0)							*/
+/************************************************************************/
 #ifdef _HPUX_SOURCE
-	long linearLSCF (double *xdata, double *ydata, long num, double *slope, double *intercept, double *corrCoef)
+	long utcToLocalDateTime (long UTCsec, long *localDate, long *localTime)
 #else
-	DllExport long __cdecl linearLSCF (double *xdata, double *ydata, long num, double *slope, double *intercept, double *corrCoef)
+	DllExport long __cdecl utcToLocalDateTime (long UTCsec, long *localDate, long *localTime)
 #endif
 {
-	double sumX;
-	double sumX2;
-	double sumY;
-	double sumY2;
-	double sumXY;
-	double a, b, r;
-	long ii;
-	double xnum;
+	*localDate=0;
+	*localTime=0;
 
-	*slope=0.0;
-	*intercept=0.0;
-	*corrCoef=0.0;
-
-	if (num < 2) return -1;
-
-	if (num == 2)
+	if (UTCsec <= 0)return -1;
+	if (tzLocalDateTime((tdsInt64)UTCsec,-1,localDate,localTime) < 0)
 	{
-		if (xdata[0] == xdata[1])return -1;
-		a=(ydata[0] - ydata[1])/(xdata[0] - xdata[1]);
-
-		b=ydata[0] - a*xdata[0];
-		*slope=a;
-		*intercept=b;
-		*corrCoef=1.0;
-		return 0;
+		*localDate=0;
+		*localTime=0;
+		return -1;
 	}
 
-	sumX=0.0;
-	sumX2=0.0;
-	sumY=0.0;
-	sumY2=0.0;
-	sumXY=0.0;
-	xnum=(double)num;
+	return 0;
+}
+
+/************************************************************************/
+/*																		*/
+/* utcToLocalDateTime_array: Batch version of utcToLocalDateTime		*/
+/*																		*/
+/*	UTCsec: array of UTC seconds										*/
+/*	num: number of values in UTCsec										*/
+/*	localDate: returned local dates as yyyymmdd							*/
+/*	localTime: returned local times as hhmmss							*/
+/*																		*/
+/* Time ordered input is fastest; the offset table entry found for one	*/
+/* value is tried first for the next one.								*/
+/*																		*/
+/* Function returns 0 if no error, -1 if num < 1, -2 if one or more		*/
+/*	UTC seconds are in error (their localDate and localTime are 0)		*/
+/************************************************************************/
+#ifdef _HPUX_SOURCE
+	long utcToLocalDateTime_array (long *UTCsec, long num, long *localDate, long *localTime)
+#else
+	DllExport long __cdecl utcToLocalDateTime_array (long *UTCsec, long num, long *localDate, long *localTime)
+#endif
+{
+	long ii, hint, entry, result;
 
+	if (num < 1)return -1;
+
+	result=0;
+	hint=-1;
 	for (ii=0;ii<num;ii++)
 	{
-		sumX=sumX + xdata[ii];
-		sumX2=sumX2 + xdata[ii] * xdata[ii];
-		sumY=sumY + ydata[ii];
-		sumY2=sumY2 + ydata[ii] * ydata[ii];
-		sumXY=sumXY + xdata[ii] * ydata[ii];
+		entry=-1;
+		if (UTCsec[ii] > 0) entry=tzLocalDateTime((tdsInt64)UTCsec[ii],hint,&localDate[ii],&localTime[ii]);
+
+		if (entry < 0)
+		{
+			localDate[ii]=0;
+			localTime[ii]=0;
+			result=-2;
+			continue;
+		}
+		hint=entry;
 	}
 
-	if (xnum * sumX2 == sumX * sumX)return -1;
+	return result;
+}
 
-	a=(xnum * sumXY - sumX * sumY)/(xnum * sumX2 - sumX * sumX);
-	b=(sumY/xnum) - (a * (sumX/xnum));
+/************************************************************************/
+/*																		*/
+/* utcToLocalDateTime64_array: 64 bit version of						*/
+/*		utcToLocalDateTime_array.  UTC seconds are 64 bit integers, so	*/
+/*		the same call works on 32 bit and 64 bit (LP64) hosts and for	*/
+/*		dates after January 2038, whatever the size of time_t.			*/
+/*		Where time_t is 32 bit the offset table ends in January 2038,	*/
+/*		with a 64 bit time_t it runs to the end of 2199.  Later dates	*/
+/*		use the offsets of an equivalent year in the table (same number	*/
+/*		of days, same starting weekday), so the DST rules in force at	*/
+/*		the end of the table carry on.									*/
+/*																		*/
+/*	UTCsec: array of UTC seconds (64 bit)								*/
+/*	num: number of values in UTCsec										*/
+/*	localDate: returned local dates as yyyymmdd							*/
+/*	localTime: returned local times as hhmmss							*/
+/*																		*/
+/* Function returns 0 if no error, -1 if num < 1, -2 if one or more		*/
+/*	UTC seconds are in error (their localDate and localTime are 0)		*/
+/************************************************************************/
+#ifdef _HPUX_SOURCE
+	long utcToLocalDateTime64_array (tdsInt64 *UTCsec, long num, long *localDate, long *localTime)
+#else
+	DllExport long __cdecl utcToLocalDateTime64_array (tdsInt64 *UTCsec, long num, long *localDate, long *localTime)
+#endif
+{
+	long ii, hint, entry, result;
 
-	*slope=a;
-	*intercept=b;
+	if (num < 1)return -1;
 
-	r=(xnum * sumY2 - sumY * sumY) * (xnum * sumX2 - sumX * sumX);
+	result=0;
+	hint=-1;
+	for (ii=0;ii<num;ii++)
+	{
+		entry=-1;
+		if (UTCsec[ii] > 0) entry=tzLocalDateTime(UTCsec[ii],hint,&localDate[ii],&localTime[ii]);
 
-	if (r <= 0.0)return -1;
+		if (entry < 0)
+		{
+			localDate[ii]=0;
+			localTime[ii]=0;
+			result=-2;
+			continue;
+		}
+		hint=entry;
+	}
 
-	r=(xnum * sumXY - sumX * sumY)/sqrt(r);
+	return result;
+}
 
-	*corrCoef=r;
+/************************************************************************/
+/*																		*/
+/* utcUsecToLocalDateTime64_array: Same as utcToLocalDateTime64_array	*/
+/*		for UTC time given as 64 bit microseconds.						*/
+/*																		*/
+/*	UTCusec: array of UTC microseconds (64 bit)							*/
+/*	num: number of values in UTCusec									*/
+/*	localDate: returned local dates as yyyymmdd							*/
+/*	localTime: returned local times as hhmmss							*/
+/*	microsec: returned microseconds within the second (0 to 999999)		*/
+/*																		*/
+/* Function returns 0 if no error, -1 if num < 1, -2 if one or more		*/
+/*	UTC values are in error (their outputs are 0)						*/
+/************************************************************************/
+#ifdef _HPUX_SOURCE
+	long utcUsecToLocalDateTime64_array (tdsInt64 *UTCusec, long num, long *localDate, long *localTime, long *microsec)
+#else
+	DllExport long __cdecl utcUsecToLocalDateTime64_array (tdsInt64 *UTCusec, long num, long *localDate, long *localTime, long *microsec)
+#endif
+{
+	long ii, hint, entry, result;
+	tdsInt64 utc;
 
-	return 0;
-}
+	if (num < 1)return -1;
 
-/* ============= sortDoublePtr ========================== */
+	result=0;
+	hint=-1;
+	for (ii=0;ii<num;ii++)
+	{
+		utc=UTCusec[ii]/1000000;
+		entry=-1;
+		if (utc > 0) entry=tzLocalDateTime(utc,hint,&localDate[ii],&localTime[ii]);
 
-/* Modified to run on PC platform. Nuri Cankurt July 2, 2003 */
+		if (entry < 0)
+		{
+			localDate[ii]=0;
+			localTime[ii]=0;
+			microsec[ii]=0;
+			result=-2;
+			continue;
+		}
+		microsec[ii]=(long)(UTCusec[ii] - utc*1000000);
+		hint=entry;
+	}
 
-/* This function sorts a given double array 'fdata' to create
-   a pointer array 'index'.  It does not change 'fdata' in any way.
+	return result;
+}
 
-   The sorted values of 'fdata' would be:
-   fdata[index[0]], fdata[index[1]], fdata[index[2]] ....
+/************************************************************************/
+/*																		*/
+/* utcDateTimeFmtCreate: This function creates a formatter for			*/
+/*		utcToLocalDateTimeStr2_fmt.  The formatter remembers the last	*/
+/*		formatted second and local day, so consecutive samples of a		*/
+/*		time ordered stream only rewrite the digits that changed.		*/
+/*		Use one formatter per stream (or per thread).					*/
+/*																		*/
+/* Function returns the formatter, or NULL if out of memory				*/
+/*		Release it with utcDateTimeFmtFree								*/
+/************************************************************************/
+struct utcDateTimeFmt
+{
+	tdsInt64	spanStart;		/* first UTC second of cached date and offset */
+	tdsInt64	spanEnd;		/* first UTC second after them */
+	tdsInt64	dayStart;		/* UTC second of local midnight of cached date */
+	tdsInt64	lastSec;		/* last formatted UTC second, -1 if none */
+	long		lastSecOfDay;	/* local second of day of lastSec, -1 if none */
+	long		hint;			/* time zone table entry of the span */
+	char		dateStr[12];	/* mm/dd/yyyy */
+	char		timeStr[12];	/* hh:mm:ss */
+};
+typedef struct utcDateTimeFmt utcDateTimeFmt;
 
-   assending or descending.
+#ifdef _HPUX_SOURCE
+	utcDateTimeFmt *utcDateTimeFmtCreate (void)
+#else
+	DllExport utcDateTimeFmt * __cdecl utcDateTimeFmtCreate (void)
+#endif
+{
+	utcDateTimeFmt *fmt;
 
-   Written by: N. Cankurt 10-30-97
-   
-   Input variables:
-   fdata  = data
-   num    = how many values are there in fdata.
-   how   = how to sort 'a' for ascending and 'd' for descending
+	fmt=(utcDateTimeFmt *)malloc(sizeof(utcDateTimeFmt));
+	if (fmt == NULL)return NULL;
 
-   Returned variables:
-   index  = contains the index of fdata which would be in sorted order
+	fmt->spanStart=0;
+	fmt->spanEnd=0;
+	fmt->dayStart=0;
+	fmt->lastSec=-1;
+	fmt->lastSecOfDay=-1;
+	fmt->hint=-1;
+	strcpy(fmt->dateStr,"");
+	strcpy(fmt->timeStr,"");
+
+	return fmt;
+}
+
+/************************************************************************/
+/*																		*/
+/* utcDateTimeFmtFree: This function releases a formatter created by	*/
+/*		utcDateTimeFmtCreate											*/
+/************************************************************************/
+#ifdef _HPUX_SOURCE
+	void utcDateTimeFmtFree (utcDateTimeFmt *fmt)
+#else
+	DllExport void __cdecl utcDateTimeFmtFree (utcDateTimeFmt *fmt)
+#endif
+{
+	free(fmt);
+}
+
+/* caches the local date of 'utc' and the UTC span sharing that date and offset */
+static long utcDateTimeFmtNewSpan (utcDateTimeFmt *fmt, tdsInt64 utc)
+{
+	long entry, offset, secOfDay, year, month, day;
+	tdsInt64 validFrom, validTo, days;
+
+	entry=tzLookup(utc,fmt->hint,&offset,&validFrom,&validTo);
+	if (entry < 0)return -1;
+
+	days=splitDaySeconds(utc + offset,&secOfDay);
+	civilFromDays(days,&year,&month,&day);
+
+	fmt->hint=entry;
+	fmt->dayStart=days*86400 - offset;
+	fmt->spanStart=(validFrom > fmt->dayStart) ? validFrom : fmt->dayStart;
+	fmt->spanEnd=(validTo < fmt->dayStart + 86400) ? validTo : fmt->dayStart + 86400;
+	fmt->lastSecOfDay=-1;
+
+	sprintf(fmt->dateStr,"%02ld/%02ld/%04ld",month,day,year);
+	strcpy(fmt->timeStr,"00:00:00");
+
+	return 0;
+}
+
+/************************************************************************/
+/*																		*/
+/* utcToLocalDateTimeStr2_fmt: Same as utcToLocalDateTimeStr2, using	*/
+/*		the formatter 'fmt' from utcDateTimeFmtCreate.					*/
+/*																		*/
+/*	If the second is the same as the previous call only millisec is		*/
+/*	computed; inside the same minute only the seconds digits are		*/
+/*	rewritten.  The calendar is recomputed only when the local day or	*/
+/*	the UTC offset (DST) changes.  Out of order values are handled, but	*/
+/*	cost a full conversion.												*/
+/*																		*/
+/* If UTC seconds is in error, date and time strings are set to NULL	*/
+/************************************************************************/
+#ifdef _HPUX_SOURCE
+	void utcToLocalDateTimeStr2_fmt (utcDateTimeFmt *fmt, double fractionalUTCsec, char *dateStr, char *timeStr, long *millisec)
+#else
+	DllExport void __cdecl utcToLocalDateTimeStr2_fmt (utcDateTimeFmt *fmt, double fractionalUTCsec, char *dateStr, char *timeStr, long *millisec)
+#endif
+{
+	tdsInt64 utc;
+	long secOfDay, val;
+	double xx;
+
+	utc=(tdsInt64) fractionalUTCsec;
+
+	if (utc <= 0)
+	{
+		strcpy(dateStr,"");
+		strcpy(timeStr,"");
+		*millisec=0;
+		return;
+	}
+
+	if (utc != fmt->lastSec)
+	{
+		if (utc < fmt->spanStart || utc >= fmt->spanEnd)
+		{
+			if (utcDateTimeFmtNewSpan(fmt,utc) != 0)
+			{
+				fmt->lastSec=-1;
+				fmt->spanStart=fmt->spanEnd=0;
+				strcpy(dateStr,"");
+				strcpy(timeStr,"");
+				*millisec=0;
+				return;
+			}
+		}
+
+		secOfDay=(long)(utc - fmt->dayStart);
+
+		if (fmt->lastSecOfDay < 0 || secOfDay/60 != fmt->lastSecOfDay/60)
+		{
+			val=secOfDay/3600;
+			fmt->timeStr[0]=(char)('0' + val/10);
+			fmt->timeStr[1]=(char)('0' + val%10);
+			val=(secOfDay/60)%60;
+			fmt->timeStr[3]=(char)('0' + val/10);
+			fmt->timeStr[4]=(char)('0' + val%10);
+		}
+		val=secOfDay%60;
+		fmt->timeStr[6]=(char)('0' + val/10);
+		fmt->timeStr[7]=(char)('0' + val%10);
+
+		fmt->lastSecOfDay=secOfDay;
+		fmt->lastSec=utc;
+	}
+
+	memcpy(dateStr,fmt->dateStr,11);
+	memcpy(timeStr,fmt->timeStr,9);
+
+	xx=(fractionalUTCsec - (double) utc) * 1000.0;
+	*millisec = (long) xx;
+
+	return;
+}
+
+/************************************************************************/
+/*																		*/
+/* Worker threads for the parallel (..._par) functions.					*/
+/*																		*/
+/* tdsRunThreads calls func(args + ii*argSize) for ii = 0..nThreads-1,	*/
+/* item 0 on the calling thread and the others on new threads, and		*/
+/* returns when all are done.  If a thread cannot be started its item	*/
+/* is run on the calling thread instead, so the work always completes.	*/
+/* Callers split their work so the result does not depend on which		*/
+/* thread ran which item.												*/
+/************************************************************************/
+#define TDS_MAX_THREADS	64
+
+typedef void (*tdsWorkFunc) (void *arg);
+
+typedef struct
+{
+	tdsWorkFunc	func;
+	void		*arg;
+} tdsThreadStart;
+
+#ifdef _HPUX_SOURCE
+	static void *tdsThreadProc (void *param)
+	{
+		tdsThreadStart *ts;
+
+		ts=(tdsThreadStart *)param;
+		ts->func(ts->arg);
+
+		return NULL;
+	}
+#else
+	static DWORD WINAPI tdsThreadProc (LPVOID param)
+	{
+		tdsThreadStart *ts;
+
+		ts=(tdsThreadStart *)param;
+		ts->func(ts->arg);
+
+		return 0;
+	}
+#endif
+
+/* number of threads to use when the caller asks for 'nThreads' (<= 0 means one per CPU) */
+static long tdsNumThreads (long nThreads)
+{
+	long ncpu;
+
+	if (nThreads <= 0)
+	{
+#ifdef _HPUX_SOURCE
+		ncpu=(long)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+		SYSTEM_INFO si;
+
+		GetSystemInfo(&si);
+		ncpu=(long)si.dwNumberOfProcessors;
+#endif
+		nThreads=(ncpu > 0) ? ncpu : 1;
+	}
+	if (nThreads > TDS_MAX_THREADS) nThreads=TDS_MAX_THREADS;
+
+	return nThreads;
+}
+
+static void tdsRunThreads (long nThreads, tdsWorkFunc func, void *args, long argSize)
+{
+	tdsThreadStart start[TDS_MAX_THREADS];
+	long started[TDS_MAX_THREADS];
+	long ii;
+#ifdef _HPUX_SOURCE
+	pthread_t thread[TDS_MAX_THREADS];
+#else
+	HANDLE thread[TDS_MAX_THREADS];
+#endif
+
+	if (nThreads > TDS_MAX_THREADS) nThreads=TDS_MAX_THREADS;
+
+	for (ii=1;ii<nThreads;ii++)
+	{
+		start[ii].func=func;
+		start[ii].arg=(char *)args + ii*argSize;
+#ifdef _HPUX_SOURCE
+		started[ii]=(pthread_create(&thread[ii],NULL,tdsThreadProc,&start[ii]) == 0);
+#else
+		thread[ii]=CreateThread(NULL,0,tdsThreadProc,&start[ii],0,NULL);
+		started[ii]=(thread[ii] != NULL);
+#endif
+	}
+
+	func(args);
+
+	for (ii=1;ii<nThreads;ii++)
+	{
+		if (!started[ii])
+		{
+			func(start[ii].arg);
+			continue;
+		}
+#ifdef _HPUX_SOURCE
+		pthread_join(thread[ii],NULL);
+#else
+		WaitForSingleObject(thread[ii],INFINITE);
+		CloseHandle(thread[ii]);
+#endif
+	}
+}
+
+/* final step of linearLSCF from the raw sums, shared with linearLSCF_multi */
+static long lscfFromSums (double xnum, double sumX, double sumX2, double sumY, double sumY2, double sumXY, double *slope, double *intercept, double *corrCoef)
+{
+	double a, b, r;
+
+	if (xnum * sumX2 == sumX * sumX)return -1;
+
+	a=(xnum * sumXY - sumX * sumY)/(xnum * sumX2 - sumX * sumX);
+	b=(sumY/xnum) - (a * (sumX/xnum));
+
+	*slope=a;
+	*intercept=b;
+
+	r=(xnum * sumY2 - sumY * sumY) * (xnum * sumX2 - sumX * sumX);
+
+	if (r <= 0.0)return -1;
+
+	r=(xnum * sumXY - sumX * sumY)/sqrt(r);
+
+	*corrCoef=r;
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF: This function performs linear least square curve fit.*/
+/* and returns slope, intercept and correlation coef				*/
+/* Calling parameters:												*/
+/*   xdata=vector containing independent variable data				*/
+/*   ydata=vector containing dependent variable data				*/
+/*   num=number of data points in xdata (and in ydata)				*/
+/*																	*/
+/* Returned parameters:												*/
+/*   slope=slope of Y=aX + B (slope=a)								*/
+/*   intercept=intercept of Y=aX + B (intercept=B)					*/
+/*   corrCoef=Correlation coefficient R								*/
+/*																	*/
+/* Function returns zero if no error, -1 if error					*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long linearLSCF (double *xdata, double *ydata, long num, double *slope, double *intercept, double *corrCoef)
+#else
+	DllExport long __cdecl linearLSCF (double *xdata, double *ydata, long num, double *slope, double *intercept, double *corrCoef)
+#endif
+{
+	double sumX;
+	double sumX2;
+	double sumY;
+	double sumY2;
+	double sumXY;
+	double a, b;
+	long ii;
+	double xnum;
+
+	*slope=0.0;
+	*intercept=0.0;
+	*corrCoef=0.0;
+
+	if (num < 2) return -1;
+
+	if (num == 2)
+	{
+		if (xdata[0] == xdata[1])return -1;
+		a=(ydata[0] - ydata[1])/(xdata[0] - xdata[1]);
+
+		b=ydata[0] - a*xdata[0];
+		*slope=a;
+		*intercept=b;
+		*corrCoef=1.0;
+		return 0;
+	}
+
+	sumX=0.0;
+	sumX2=0.0;
+	sumY=0.0;
+	sumY2=0.0;
+	sumXY=0.0;
+	xnum=(double)num;
+
+	for (ii=0;ii<num;ii++)
+	{
+		sumX=sumX + xdata[ii];
+		sumX2=sumX2 + xdata[ii] * xdata[ii];
+		sumY=sumY + ydata[ii];
+		sumY2=sumY2 + ydata[ii] * ydata[ii];
+		sumXY=sumXY + xdata[ii] * ydata[ii];
+	}
+
+	return lscfFromSums(xnum,sumX,sumX2,sumY,sumY2,sumXY,slope,intercept,corrCoef);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* Streaming linear least square curve fit (linearLSCF_acc...)		*/
+/*																	*/
+/* The accumulator keeps the count, the means of x and y and the	*/
+/* sums of squares and products about those means (Welford update).	*/
+/* The means are kept relative to the first point, so unlike the	*/
+/* raw sums of linearLSCF no precision is lost when x is a large	*/
+/* time offset.  Two accumulators filled from different threads or	*/
+/* file chunks can be merged exactly (Chan et al. pairwise update).	*/
+/********************************************************************/
+typedef struct
+{
+	double	num;		/* number of points */
+	double	shiftX;		/* first point, origin of the means */
+	double	shiftY;
+	double	meanX;		/* mean of x - shiftX */
+	double	meanY;		/* mean of y - shiftY */
+	double	sXX;		/* sum of (x-meanX)^2 */
+	double	sYY;		/* sum of (y-meanY)^2 */
+	double	sXY;		/* sum of (x-meanX)*(y-meanY) */
+} lscfMoments;
+
+#define LSCF_BLOCK	1024	/* points per block in lscfMomentsAddArray */
+
+static void lscfMomentsInit (lscfMoments *mm)
+{
+	mm->num=0.0;
+	mm->shiftX=0.0;
+	mm->shiftY=0.0;
+	mm->meanX=0.0;
+	mm->meanY=0.0;
+	mm->sXX=0.0;
+	mm->sYY=0.0;
+	mm->sXY=0.0;
+}
+
+static void lscfMomentsAdd (lscfMoments *mm, double x, double y)
+{
+	double dx, dy;
+
+	if (mm->num == 0.0)
+	{
+		mm->shiftX=x;
+		mm->shiftY=y;
+	}
+	x=x - mm->shiftX;
+	y=y - mm->shiftY;
+
+	mm->num=mm->num + 1.0;
+	dx=x - mm->meanX;
+	dy=y - mm->meanY;
+	mm->meanX=mm->meanX + dx/mm->num;
+	mm->meanY=mm->meanY + dy/mm->num;
+	mm->sXX=mm->sXX + dx*(x - mm->meanX);
+	mm->sYY=mm->sYY + dy*(y - mm->meanY);
+	mm->sXY=mm->sXY + dx*(y - mm->meanY);
+}
+
+/* removes a point that was added before (reverse Welford update) */
+static void lscfMomentsRemove (lscfMoments *mm, double x, double y)
+{
+	double dx, dy, meanX, meanY;
+
+	if (mm->num <= 1.0)
+	{
+		lscfMomentsInit(mm);
+		return;
+	}
+
+	x=x - mm->shiftX;
+	y=y - mm->shiftY;
+
+	mm->num=mm->num - 1.0;
+	dx=x - mm->meanX;
+	dy=y - mm->meanY;
+	meanX=mm->meanX - dx/mm->num;
+	meanY=mm->meanY - dy/mm->num;
+	mm->sXX=mm->sXX - (x - meanX)*dx;
+	mm->sYY=mm->sYY - (y - meanY)*dy;
+	mm->sXY=mm->sXY - (x - meanX)*dy;
+	mm->meanX=meanX;
+	mm->meanY=meanY;
+
+	if (mm->sXX < 0.0) mm->sXX=0.0;
+	if (mm->sYY < 0.0) mm->sYY=0.0;
+}
+
+/* dest = aa combined with bb (dest may be aa or bb) */
+static void lscfMomentsMerge (lscfMoments *dest, const lscfMoments *aa, const lscfMoments *bb)
+{
+	lscfMoments mm;
+	double dx, dy, ff;
+
+	if (bb->num == 0.0)
+	{
+		*dest=*aa;
+		return;
+	}
+	if (aa->num == 0.0)
+	{
+		*dest=*bb;
+		return;
+	}
+
+	mm.num=aa->num + bb->num;
+	mm.shiftX=aa->shiftX;
+	mm.shiftY=aa->shiftY;
+	dx=(bb->meanX + (bb->shiftX - aa->shiftX)) - aa->meanX;
+	dy=(bb->meanY + (bb->shiftY - aa->shiftY)) - aa->meanY;
+	ff=aa->num*bb->num/mm.num;
+
+	mm.meanX=aa->meanX + dx*(bb->num/mm.num);
+	mm.meanY=aa->meanY + dy*(bb->num/mm.num);
+	mm.sXX=aa->sXX + bb->sXX + dx*dx*ff;
+	mm.sYY=aa->sYY + bb->sYY + dy*dy*ff;
+	mm.sXY=aa->sXY + bb->sXY + dx*dy*ff;
+
+	*dest=mm;
+}
+
+/* adds arrays block by block: exact two pass moments per block, then merge */
+static void lscfMomentsAddArray (lscfMoments *mm, const double *xdata, const double *ydata, long num)
+{
+	lscfMoments blk;
+	long ii, jj, nb;
+	double sx, sy, dx, dy, x0, y0;
+
+	for (ii=0;ii<num;ii+=LSCF_BLOCK)
+	{
+		nb=(num - ii < LSCF_BLOCK) ? num - ii : LSCF_BLOCK;
+
+		x0=xdata[ii];
+		y0=ydata[ii];
+		sx=0.0;
+		sy=0.0;
+		for (jj=ii;jj<ii+nb;jj++)
+		{
+			sx=sx + (xdata[jj] - x0);
+			sy=sy + (ydata[jj] - y0);
+		}
+
+		blk.num=(double)nb;
+		blk.shiftX=x0;
+		blk.shiftY=y0;
+		blk.meanX=sx/blk.num;
+		blk.meanY=sy/blk.num;
+		blk.sXX=0.0;
+		blk.sYY=0.0;
+		blk.sXY=0.0;
+		for (jj=ii;jj<ii+nb;jj++)
+		{
+			dx=(xdata[jj] - x0) - blk.meanX;
+			dy=(ydata[jj] - y0) - blk.meanY;
+			blk.sXX=blk.sXX + dx*dx;
+			blk.sYY=blk.sYY + dy*dy;
+			blk.sXY=blk.sXY + dx*dy;
+		}
+
+		lscfMomentsMerge(mm,mm,&blk);
+	}
+}
+
+/* slope, intercept and correlation coef with the return conventions of linearLSCF */
+static long lscfMomentsResult (const lscfMoments *mm, double *slope, double *intercept, double *corrCoef)
+{
+	double a, r;
+
+	*slope=0.0;
+	*intercept=0.0;
+	*corrCoef=0.0;
+
+	if (mm->num < 2.0)return -1;
+	if (mm->sXX <= 0.0)return -1;
+
+	a=mm->sXY/mm->sXX;
+	*slope=a;
+	*intercept=(mm->shiftY + mm->meanY) - a*(mm->shiftX + mm->meanX);
+
+	if (mm->num == 2.0)
+	{
+		*corrCoef=1.0;
+		return 0;
+	}
+
+	r=mm->sXX*mm->sYY;
+	if (r <= 0.0)return -1;
+
+	*corrCoef=mm->sXY/sqrt(r);
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_accCreate: This function creates an empty accumulator	*/
+/*	for a streaming linear least square curve fit.					*/
+/*																	*/
+/* Function returns the accumulator, or NULL if out of memory.		*/
+/*	Release it with linearLSCF_accFree								*/
+/********************************************************************/
+struct lscfAccum
+{
+	lscfMoments	mm;
+};
+typedef struct lscfAccum lscfAccum;
+
+#ifdef _HPUX_SOURCE
+	lscfAccum *linearLSCF_accCreate (void)
+#else
+	DllExport lscfAccum * __cdecl linearLSCF_accCreate (void)
+#endif
+{
+	lscfAccum *acc;
+
+	acc=(lscfAccum *)malloc(sizeof(lscfAccum));
+	if (acc == NULL)return NULL;
+
+	lscfMomentsInit(&acc->mm);
+
+	return acc;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_accFree: This function releases an accumulator		*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	void linearLSCF_accFree (lscfAccum *acc)
+#else
+	DllExport void __cdecl linearLSCF_accFree (lscfAccum *acc)
+#endif
+{
+	free(acc);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_accReset: This function empties an accumulator		*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	void linearLSCF_accReset (lscfAccum *acc)
+#else
+	DllExport void __cdecl linearLSCF_accReset (lscfAccum *acc)
+#endif
+{
+	lscfMomentsInit(&acc->mm);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_accAdd: This function adds one point (x, y)			*/
+/*																	*/
+/* Function always returns 0										*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long linearLSCF_accAdd (lscfAccum *acc, double x, double y)
+#else
+	DllExport long __cdecl linearLSCF_accAdd (lscfAccum *acc, double x, double y)
+#endif
+{
+	lscfMomentsAdd(&acc->mm,x,y);
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_accAddArray: This function adds 'num' points			*/
+/*   xdata=vector containing independent variable data				*/
+/*   ydata=vector containing dependent variable data				*/
+/*																	*/
+/* Function returns zero if no error, -1 if num < 0					*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long linearLSCF_accAddArray (lscfAccum *acc, double *xdata, double *ydata, long num)
+#else
+	DllExport long __cdecl linearLSCF_accAddArray (lscfAccum *acc, double *xdata, double *ydata, long num)
+#endif
+{
+	if (num < 0)return -1;
+
+	lscfMomentsAddArray(&acc->mm,xdata,ydata,num);
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_accMerge: This function sets 'dest' to the points of	*/
+/*	'acc1' and 'acc2' together.  'dest' may be one of them			*/
+/*	(i.e. linearLSCF_accMerge(total, total, part))					*/
+/*																	*/
+/* Function always returns 0										*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long linearLSCF_accMerge (lscfAccum *dest, lscfAccum *acc1, lscfAccum *acc2)
+#else
+	DllExport long __cdecl linearLSCF_accMerge (lscfAccum *dest, lscfAccum *acc1, lscfAccum *acc2)
+#endif
+{
+	lscfMomentsMerge(&dest->mm,&acc1->mm,&acc2->mm);
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_accResult: This function returns slope, intercept and	*/
+/*	correlation coef of the points added so far, with the same		*/
+/*	outputs and return conventions as linearLSCF:					*/
+/*   slope=slope of Y=aX + B (slope=a)								*/
+/*   intercept=intercept of Y=aX + B (intercept=B)					*/
+/*   corrCoef=Correlation coefficient R								*/
+/*																	*/
+/* Function returns zero if no error, -1 if error					*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long linearLSCF_accResult (lscfAccum *acc, double *slope, double *intercept, double *corrCoef)
+#else
+	DllExport long __cdecl linearLSCF_accResult (lscfAccum *acc, double *slope, double *intercept, double *corrCoef)
+#endif
+{
+	return lscfMomentsResult(&acc->mm,slope,intercept,corrCoef);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* Rolling linear least square curve fit (linearLSCF_roll...)		*/
+/*																	*/
+/* Fits the last 'window' points.  Each new point is added and the	*/
+/* oldest one removed with a Welford update and its reverse, so a	*/
+/* new fit costs the same for any window size.  To keep rounding	*/
+/* from building up in the removals, the moments are recomputed		*/
+/* from the window contents every 'window' points (O(1) amortized).	*/
+/********************************************************************/
+struct lscfRolling
+{
+	long		window;
+	long		count;			/* points in the window */
+	long		head;			/* slot of the oldest point */
+	long		sinceRefresh;	/* removals since moments were recomputed */
+	double		*xbuf;
+	double		*ybuf;
+	lscfMoments	mm;
+};
+typedef struct lscfRolling lscfRolling;
+
+/* recomputes the moments from the points in the window */
+static void lscfRollingRefresh (lscfRolling *roll)
+{
+	long first;
+
+	lscfMomentsInit(&roll->mm);
+
+	first=roll->window - roll->head;
+	if (first > roll->count) first=roll->count;
+
+	lscfMomentsAddArray(&roll->mm,roll->xbuf+roll->head,roll->ybuf+roll->head,first);
+	lscfMomentsAddArray(&roll->mm,roll->xbuf,roll->ybuf,roll->count-first);
+
+	roll->sinceRefresh=0;
+}
+
+static void lscfRollingAdd (lscfRolling *roll, double x, double y)
+{
+	long slot;
+
+	if (roll->count == roll->window)
+	{
+		lscfMomentsRemove(&roll->mm,roll->xbuf[roll->head],roll->ybuf[roll->head]);
+		roll->head=(roll->head + 1)%roll->window;
+		roll->count--;
+		roll->sinceRefresh++;
+	}
+
+	slot=(roll->head + roll->count)%roll->window;
+	roll->xbuf[slot]=x;
+	roll->ybuf[slot]=y;
+	roll->count++;
+	lscfMomentsAdd(&roll->mm,x,y);
+
+	if (roll->sinceRefresh >= roll->window) lscfRollingRefresh(roll);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_rollCreate: This function creates a rolling fit over	*/
+/*	the last 'window' points (window >= 2)							*/
+/*																	*/
+/* Function returns the rolling fit, or NULL if window < 2 or out	*/
+/*	of memory.  Release it with linearLSCF_rollFree					*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	lscfRolling *linearLSCF_rollCreate (long window)
+#else
+	DllExport lscfRolling * __cdecl linearLSCF_rollCreate (long window)
+#endif
+{
+	lscfRolling *roll;
+
+	if (window < 2)return NULL;
+
+	roll=(lscfRolling *)malloc(sizeof(lscfRolling));
+	if (roll == NULL)return NULL;
+
+	roll->xbuf=(double *)malloc(window*sizeof(double));
+	roll->ybuf=(double *)malloc(window*sizeof(double));
+	if (roll->xbuf == NULL || roll->ybuf == NULL)
+	{
+		free(roll->xbuf);
+		free(roll->ybuf);
+		free(roll);
+		return NULL;
+	}
+
+	roll->window=window;
+	roll->count=0;
+	roll->head=0;
+	roll->sinceRefresh=0;
+	lscfMomentsInit(&roll->mm);
+
+	return roll;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_rollFree: This function releases a rolling fit		*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	void linearLSCF_rollFree (lscfRolling *roll)
+#else
+	DllExport void __cdecl linearLSCF_rollFree (lscfRolling *roll)
+#endif
+{
+	if (roll == NULL)return;
+
+	free(roll->xbuf);
+	free(roll->ybuf);
+	free(roll);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_rollAdd: This function adds point (x, y), drops the	*/
+/*	oldest point if the window is full, and returns the fit of the	*/
+/*	points now in the window (see linearLSCF):						*/
+/*   slope=slope of Y=aX + B (slope=a)								*/
+/*   intercept=intercept of Y=aX + B (intercept=B)					*/
+/*   corrCoef=Correlation coefficient R								*/
+/*																	*/
+/* Function returns zero if no error, 1 if no error but the window	*/
+/*	is not full yet, -1 if error									*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long linearLSCF_rollAdd (lscfRolling *roll, double x, double y, double *slope, double *intercept, double *corrCoef)
+#else
+	DllExport long __cdecl linearLSCF_rollAdd (lscfRolling *roll, double x, double y, double *slope, double *intercept, double *corrCoef)
+#endif
+{
+	lscfRollingAdd(roll,x,y);
+
+	if (lscfMomentsResult(&roll->mm,slope,intercept,corrCoef) != 0)return -1;
+	if (roll->count < roll->window)return 1;
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_rolling: This function fits every window of 'window'	*/
+/*	consecutive points of xdata and ydata.							*/
+/*   num=number of data points in xdata (and in ydata)				*/
+/*																	*/
+/* Returned parameters (num-window+1 values each, value k is the	*/
+/*	fit of points k to k+window-1):									*/
+/*   slope, intercept, corrCoef as returned by linearLSCF			*/
+/*																	*/
+/* Function returns zero if no error, -1 if window < 2 or			*/
+/*	num < window, -2 if the fit failed for one or more windows		*/
+/*	(their values are set as linearLSCF does), -3 out of memory		*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long linearLSCF_rolling (double *xdata, double *ydata, long num, long window, double *slope, double *intercept, double *corrCoef)
+#else
+	DllExport long __cdecl linearLSCF_rolling (double *xdata, double *ydata, long num, long window, double *slope, double *intercept, double *corrCoef)
+#endif
+{
+	lscfRolling *roll;
+	long ii, kk, result;
+
+	if (window < 2 || num < window)return -1;
+
+	roll=linearLSCF_rollCreate(window);
+	if (roll == NULL)return -3;
+
+	for (ii=0;ii<window-1;ii++)lscfRollingAdd(roll,xdata[ii],ydata[ii]);
+
+	result=0;
+	for (ii=window-1;ii<num;ii++)
+	{
+		kk=ii - window + 1;
+		lscfRollingAdd(roll,xdata[ii],ydata[ii]);
+		if (lscfMomentsResult(&roll->mm,&slope[kk],&intercept[kk],&corrCoef[kk]) != 0) result=-2;
+	}
+
+	linearLSCF_rollFree(roll);
+
+	return result;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_multi: This function performs linearLSCF for 'numY'	*/
+/*	channels against the same xdata.  Each channel's result is the	*/
+/*	same as calling linearLSCF(xdata, channel, ...) on it, but the	*/
+/*	sums of x are computed once and the data is processed in tiles	*/
+/*	of LSCF_TILE_ROWS points by LSCF_TILE_CHAN channels, so a tile	*/
+/*	of xdata stays in cache while the channels stream past it.		*/
+/*																	*/
+/* Calling parameters:												*/
+/*   xdata=vector containing independent variable data				*/
+/*   ydata=matrix containing dependent variable data, num x numY,	*/
+/*		column major (channel k is ydata[k*num] to					*/
+/*		ydata[k*num+num-1])											*/
+/*   num=number of data points in xdata (and in each channel)		*/
+/*   numY=number of channels										*/
+/*																	*/
+/* Returned parameters (numY values each):							*/
+/*   slope, intercept, corrCoef as returned by linearLSCF			*/
+/*																	*/
+/* Function returns zero if no error, -1 if num < 2 or numY < 1,	*/
+/*	-2 if linearLSCF would return -1 for one or more channels,		*/
+/*	-3 out of memory												*/
+/********************************************************************/
+#define LSCF_TILE_ROWS	512
+#define LSCF_TILE_CHAN	4
+
+#ifdef _HPUX_SOURCE
+	long linearLSCF_multi (double *xdata, double *ydata, long num, long numY, double *slope, double *intercept, double *corrCoef)
+#else
+	DllExport long __cdecl linearLSCF_multi (double *xdata, double *ydata, long num, long numY, double *slope, double *intercept, double *corrCoef)
+#endif
+{
+	double sumX;
+	double sumX2;
+	double *sums;		/* sumY, sumY2, sumXY of each channel */
+	double *yy;
+	double *tile[LSCF_TILE_CHAN];
+	double sY[LSCF_TILE_CHAN], sY2[LSCF_TILE_CHAN], sXY[LSCF_TILE_CHAN];
+	double xnum, xv, yv;
+	long ii, jj, kk, ch, rowEnd, chanEnd, result;
+
+	for (ch=0;ch<numY;ch++)
+	{
+		slope[ch]=0.0;
+		intercept[ch]=0.0;
+		corrCoef[ch]=0.0;
+	}
+
+	if (num < 2 || numY < 1)return -1;
+
+	result=0;
+	if (num == 2)
+	{
+		for (ch=0;ch<numY;ch++)
+		{
+			if (linearLSCF(xdata,ydata+ch*num,num,&slope[ch],&intercept[ch],&corrCoef[ch]) != 0) result=-2;
+		}
+		return result;
+	}
+
+	sums=(double *)calloc(3*numY,sizeof(double));
+	if (sums == NULL)return -3;
+
+	sumX=0.0;
+	sumX2=0.0;
+	xnum=(double)num;
+
+	for (ii=0;ii<num;ii++)
+	{
+		sumX=sumX + xdata[ii];
+		sumX2=sumX2 + xdata[ii] * xdata[ii];
+	}
+
+	/* sums of each channel are built in the same order as linearLSCF does.
+	   A full tile of channels shares each load of xdata */
+	for (ii=0;ii<num;ii=rowEnd)
+	{
+		rowEnd=(num - ii < LSCF_TILE_ROWS) ? num : ii + LSCF_TILE_ROWS;
+
+		for (ch=0;ch<numY;ch=chanEnd)
+		{
+			chanEnd=(numY - ch < LSCF_TILE_CHAN) ? numY : ch + LSCF_TILE_CHAN;
+
+			if (chanEnd - ch == LSCF_TILE_CHAN)
+			{
+				for (kk=0;kk<LSCF_TILE_CHAN;kk++)
+				{
+					tile[kk]=ydata + (ch+kk)*num;
+					sY[kk]=sums[3*(ch+kk)];
+					sY2[kk]=sums[3*(ch+kk)+1];
+					sXY[kk]=sums[3*(ch+kk)+2];
+				}
+				for (jj=ii;jj<rowEnd;jj++)
+				{
+					xv=xdata[jj];
+					for (kk=0;kk<LSCF_TILE_CHAN;kk++)
+					{
+						yv=tile[kk][jj];
+						sY[kk]=sY[kk] + yv;
+						sY2[kk]=sY2[kk] + yv * yv;
+						sXY[kk]=sXY[kk] + xv * yv;
+					}
+				}
+				for (kk=0;kk<LSCF_TILE_CHAN;kk++)
+				{
+					sums[3*(ch+kk)]=sY[kk];
+					sums[3*(ch+kk)+1]=sY2[kk];
+					sums[3*(ch+kk)+2]=sXY[kk];
+				}
+				continue;
+			}
+
+			for (kk=ch;kk<chanEnd;kk++)
+			{
+				yy=ydata + kk*num;
+				for (jj=ii;jj<rowEnd;jj++)
+				{
+					xv=xdata[jj];
+					yv=yy[jj];
+					sums[3*kk]=sums[3*kk] + yv;
+					sums[3*kk+1]=sums[3*kk+1] + yv * yv;
+					sums[3*kk+2]=sums[3*kk+2] + xv * yv;
+				}
+			}
+		}
+	}
+
+	for (ch=0;ch<numY;ch++)
+	{
+		if (lscfFromSums(xnum,sumX,sumX2,sums[3*ch],sums[3*ch+1],sums[3*ch+2],&slope[ch],&intercept[ch],&corrCoef[ch]) != 0) result=-2;
+	}
+
+	free(sums);
+
+	return result;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_par: This function performs linear least square curve	*/
+/*	fit like linearLSCF, for very large 'num', on several threads.	*/
+/*																	*/
+/* The data is cut into blocks of LSCF_PAR_BLOCK points.  Each		*/
+/* block's centered moments are computed exactly in two passes		*/
+/* (see linearLSCF_acc...) and the blocks are then combined			*/
+/* pairwise in a fixed tree order.  The block boundaries and the	*/
+/* tree do not depend on the number of threads, so the result is	*/
+/* the same, bit for bit, for any 'nThreads'.  Rounding error grows	*/
+/* only with log(num) instead of num as with the raw sums of		*/
+/* linearLSCF, so results can differ from linearLSCF in the last	*/
+/* digits (linearLSCF_par is the more accurate one).				*/
+/*																	*/
+/* Calling parameters:												*/
+/*   xdata=vector containing independent variable data				*/
+/*   ydata=vector containing dependent variable data				*/
+/*   num=number of data points in xdata (and in ydata)				*/
+/*   nThreads=number of threads, 0 for one per CPU					*/
+/*																	*/
+/* Returned parameters:												*/
+/*   slope=slope of Y=aX + B (slope=a)								*/
+/*   intercept=intercept of Y=aX + B (intercept=B)					*/
+/*   corrCoef=Correlation coefficient R								*/
+/*																	*/
+/* Function returns zero if no error, -1 if error, -3 if out of		*/
+/*	memory															*/
+/********************************************************************/
+#define LSCF_PAR_BLOCK	4096
+
+typedef struct
+{
+	double		*xdata;
+	double		*ydata;
+	long		num;
+	long		firstBlock;
+	long		endBlock;
+	lscfMoments	*blocks;
+} lscfParWork;
+
+static void lscfParWorker (void *arg)
+{
+	lscfParWork *work;
+	long bb, first, nb;
+
+	work=(lscfParWork *)arg;
+	for (bb=work->firstBlock;bb<work->endBlock;bb++)
+	{
+		first=bb*LSCF_PAR_BLOCK;
+		nb=(work->num - first < LSCF_PAR_BLOCK) ? work->num - first : LSCF_PAR_BLOCK;
+
+		lscfMomentsInit(&work->blocks[bb]);
+		lscfMomentsAddArray(&work->blocks[bb],work->xdata+first,work->ydata+first,nb);
+	}
+}
+
+#ifdef _HPUX_SOURCE
+	long linearLSCF_par (double *xdata, double *ydata, long num, long nThreads, double *slope, double *intercept, double *corrCoef)
+#else
+	DllExport long __cdecl linearLSCF_par (double *xdata, double *ydata, long num, long nThreads, double *slope, double *intercept, double *corrCoef)
+#endif
+{
+	lscfParWork work[TDS_MAX_THREADS];
+	lscfMoments *blocks;
+	long numBlocks, tt, step, bb, result;
+
+	*slope=0.0;
+	*intercept=0.0;
+	*corrCoef=0.0;
+
+	if (num < 2)return -1;
+
+	numBlocks=(num + LSCF_PAR_BLOCK - 1)/LSCF_PAR_BLOCK;
+	blocks=(lscfMoments *)malloc(numBlocks*sizeof(lscfMoments));
+	if (blocks == NULL)return -3;
+
+	nThreads=tdsNumThreads(nThreads);
+	if (nThreads > numBlocks) nThreads=numBlocks;
+
+	for (tt=0;tt<nThreads;tt++)
+	{
+		work[tt].xdata=xdata;
+		work[tt].ydata=ydata;
+		work[tt].num=num;
+		work[tt].firstBlock=(long)(((double)numBlocks*tt)/nThreads);
+		work[tt].endBlock=(long)(((double)numBlocks*(tt+1))/nThreads);
+		work[tt].blocks=blocks;
+	}
+	work[nThreads-1].endBlock=numBlocks;
+
+	tdsRunThreads(nThreads,lscfParWorker,work,sizeof(lscfParWork));
+
+	/* fixed pairwise tree: ((b0+b1)+(b2+b3))+... */
+	for (step=1;step<numBlocks;step*=2)
+	{
+		for (bb=0;bb+step<numBlocks;bb+=2*step)
+		{
+			lscfMomentsMerge(&blocks[bb],&blocks[bb],&blocks[bb+step]);
+		}
+	}
+
+	result=lscfMomentsResult(&blocks[0],slope,intercept,corrCoef);
+	free(blocks);
+
+	return result;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_weighted: This function performs weighted linear		*/
+/*	least square curve fit, minimizing sum of w*(y - aX - B)^2		*/
+/*																	*/
+/* The weighted means are found first and the sums of squares are	*/
+/* then taken about them (two passes), so no precision is lost		*/
+/* when x is a large time offset.									*/
+/*																	*/
+/* Calling parameters:												*/
+/*   xdata=vector containing independent variable data				*/
+/*   ydata=vector containing dependent variable data				*/
+/*   wdata=vector containing the weight of each point (>= 0).		*/
+/*		Points with weight 0 are ignored							*/
+/*   num=number of data points in xdata (and in ydata, wdata)		*/
+/*																	*/
+/* Returned parameters:												*/
+/*   slope=slope of Y=aX + B (slope=a)								*/
+/*   intercept=intercept of Y=aX + B (intercept=B)					*/
+/*   corrCoef=weighted correlation coefficient R					*/
+/*																	*/
+/* Function returns zero if no error, -1 if error (as linearLSCF,	*/
+/*	counting only points with weight > 0), -2 if a weight is < 0	*/
+/********************************************************************/
+
+/* weighted means and centered sums of xdata, without y */
+static long lscfWeightedX (double *xdata, double *wdata, long num, lscfMoments *mm)
+{
+	long ii;
+	double sw, sx, dx;
+
+	lscfMomentsInit(mm);
+
+	sw=0.0;
+	sx=0.0;
+	for (ii=0;ii<num;ii++)
+	{
+		if (wdata[ii] < 0.0 || wdata[ii] != wdata[ii])return -2;
+		if (wdata[ii] == 0.0)continue;
+		if (mm->num == 0.0) mm->shiftX=xdata[ii];
+		mm->num=mm->num + 1.0;
+		sw=sw + wdata[ii];
+		sx=sx + wdata[ii]*(xdata[ii] - mm->shiftX);
+	}
+	if (mm->num < 2.0)return -1;
+
+	mm->meanX=sx/sw;
+	for (ii=0;ii<num;ii++)
+	{
+		dx=(xdata[ii] - mm->shiftX) - mm->meanX;
+		mm->sXX=mm->sXX + wdata[ii]*dx*dx;
+	}
+
+	return 0;
+}
+
+/* adds ydata to the moments from lscfWeightedX and returns the fit */
+static long lscfWeightedY (double *xdata, double *ydata, double *wdata, long num, lscfMoments *mm, double *slope, double *intercept, double *corrCoef)
+{
+	long ii;
+	double sw, sy, dx, dy;
+
+	mm->shiftY=0.0;
+	for (ii=0;ii<num;ii++)
+	{
+		if (wdata[ii] > 0.0)
+		{
+			mm->shiftY=ydata[ii];
+			break;
+		}
+	}
+
+	sw=0.0;
+	sy=0.0;
+	for (ii=0;ii<num;ii++)
+	{
+		sw=sw + wdata[ii];
+		sy=sy + wdata[ii]*(ydata[ii] - mm->shiftY);
+	}
+	mm->meanY=sy/sw;
+
+	mm->sYY=0.0;
+	mm->sXY=0.0;
+	for (ii=0;ii<num;ii++)
+	{
+		dx=(xdata[ii] - mm->shiftX) - mm->meanX;
+		dy=(ydata[ii] - mm->shiftY) - mm->meanY;
+		mm->sYY=mm->sYY + wdata[ii]*dy*dy;
+		mm->sXY=mm->sXY + wdata[ii]*dx*dy;
+	}
+
+	return lscfMomentsResult(mm,slope,intercept,corrCoef);
+}
+
+#ifdef _HPUX_SOURCE
+	long linearLSCF_weighted (double *xdata, double *ydata, double *wdata, long num, double *slope, double *intercept, double *corrCoef)
+#else
+	DllExport long __cdecl linearLSCF_weighted (double *xdata, double *ydata, double *wdata, long num, double *slope, double *intercept, double *corrCoef)
+#endif
+{
+	lscfMoments mm;
+	long result;
+
+	*slope=0.0;
+	*intercept=0.0;
+	*corrCoef=0.0;
+
+	if (num < 2)return -1;
+
+	result=lscfWeightedX(xdata,wdata,num,&mm);
+	if (result != 0)return result;
+
+	return lscfWeightedY(xdata,ydata,wdata,num,&mm,slope,intercept,corrCoef);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* linearLSCF_weighted_multi: This function performs				*/
+/*	linearLSCF_weighted for 'numY' channels sharing the same xdata	*/
+/*	and weights.  The x part of the fit is computed once.			*/
+/*																	*/
+/* Calling parameters:												*/
+/*   xdata=vector containing independent variable data				*/
+/*   ydata=num x numY values, column major (channel k is			*/
+/*		ydata[k*num] to ydata[k*num+num-1])							*/
+/*   wdata=vector containing the weight of each point (>= 0)		*/
+/*   num=number of data points in xdata, wdata and each channel		*/
+/*   numY=number of channels										*/
+/*																	*/
+/* Returned parameters (numY values each):							*/
+/*   slope, intercept, corrCoef as returned by linearLSCF_weighted	*/
+/*																	*/
+/* Function returns zero if no error, -1 if num < 2, numY < 1 or	*/
+/*	the x data can not be fitted, -2 if linearLSCF_weighted would	*/
+/*	return -1 for one or more channels (as corrMatrix), -4 if a		*/
+/*	weight is < 0													*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long linearLSCF_weighted_multi (double *xdata, double *ydata, double *wdata, long num, long numY, double *slope, double *intercept, double *corrCoef)
+#else
+	DllExport long __cdecl linearLSCF_weighted_multi (double *xdata, double *ydata, double *wdata, long num, long numY, double *slope, double *intercept, double *corrCoef)
+#endif
+{
+	lscfMoments mx, mm;
+	long ch, result;
+
+	for (ch=0;ch<numY;ch++)
+	{
+		slope[ch]=0.0;
+		intercept[ch]=0.0;
+		corrCoef[ch]=0.0;
+	}
+
+	if (num < 2 || numY < 1)return -1;
+
+	result=lscfWeightedX(xdata,wdata,num,&mx);
+	if (result == -2)return -4;
+	if (result != 0)return result;
+
+	for (ch=0;ch<numY;ch++)
+	{
+		mm=mx;
+		if (lscfWeightedY(xdata,ydata+ch*num,wdata,num,&mm,&slope[ch],&intercept[ch],&corrCoef[ch]) != 0) result=-2;
+	}
+
+	return result;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* corrMatrix: This function computes the Pearson correlation		*/
+/*	coefficients of all pairs of 'numY' channels (the corrCoef of	*/
+/*	linearLSCF for every pair).										*/
+/*																	*/
+/* Each channel is standardized once, (y - mean)/norm, into a work	*/
+/* copy of num x numY doubles (as much memory again as ydata).  The	*/
+/* matrix is then built in blocks of CORR_BLOCK x CORR_BLOCK		*/
+/* channels over CORR_TILE_ROWS rows at a time, so the rows of both	*/
+/* channel blocks stay in cache while all their products are		*/
+/* summed.  Only blocks on or above the diagonal are computed and	*/
+/* mirrored.  Blocks are shared out to the threads, and each		*/
+/* coefficient is summed by one thread in a fixed order, so the		*/
+/* result does not depend on 'nThreads'.							*/
+/*																	*/
+/* Calling parameters:												*/
+/*   ydata=num x numY values, column major (channel k is			*/
+/*		ydata[k*num] to ydata[k*num+num-1])							*/
+/*   num=number of data points in each channel						*/
+/*   numY=number of channels										*/
+/*   nThreads=number of threads, 0 for one per CPU					*/
+/*																	*/
+/* Returned parameters:												*/
+/*   corr=numY x numY values, corr[i*numY+j] is the correlation of	*/
+/*		channels i and j (corr[i*numY+i]=1)							*/
+/*																	*/
+/* Function returns zero if no error, -1 if num < 2 or numY < 1,	*/
+/*	-2 if one or more channels are constant (their row, column		*/
+/*	and diagonal are set to 0), -3 if out of memory					*/
+/********************************************************************/
+#define CORR_BLOCK		32
+#define CORR_TILE_ROWS	256
+
+typedef struct
+{
+	double	*zdata;		/* standardized channels, column major like ydata */
+	long	num;
+	long	numY;
+	double	*corr;
+	long	first;		/* block pairs first, first+step, ... */
+	long	step;
+	long	numBlocks;
+} corrWork;
+
+static void corrWorker (void *arg)
+{
+	corrWork *work;
+	double acc[CORR_BLOCK][CORR_BLOCK];
+	double *zi, *zj, s0, s1, s2, s3, rr;
+	long pp, bi, bj, ci, cj, ni, nj, row0, nr, ii, jj, kk;
+
+	work=(corrWork *)arg;
+	for (pp=work->first;pp<work->numBlocks*(work->numBlocks+1)/2;pp+=work->step)
+	{
+		/* pp -> block pair (bi,bj), bi <= bj */
+		bi=0;
+		kk=pp;
+		while (kk >= work->numBlocks - bi)
+		{
+			kk=kk - (work->numBlocks - bi);
+			bi++;
+		}
+		bj=bi + kk;
+
+		ci=bi*CORR_BLOCK;
+		cj=bj*CORR_BLOCK;
+		ni=(work->numY - ci < CORR_BLOCK) ? work->numY - ci : CORR_BLOCK;
+		nj=(work->numY - cj < CORR_BLOCK) ? work->numY - cj : CORR_BLOCK;
+
+		for (ii=0;ii<ni;ii++) for (jj=0;jj<nj;jj++) acc[ii][jj]=0.0;
+
+		for (row0=0;row0<work->num;row0+=CORR_TILE_ROWS)
+		{
+			nr=(work->num - row0 < CORR_TILE_ROWS) ? work->num - row0 : CORR_TILE_ROWS;
+
+			for (ii=0;ii<ni;ii++)
+			{
+				zi=work->zdata + (ci+ii)*work->num + row0;
+				for (jj=(bi == bj) ? ii : 0;jj<nj;jj++)
+				{
+					zj=work->zdata + (cj+jj)*work->num + row0;
+					s0=0.0;
+					s1=0.0;
+					s2=0.0;
+					s3=0.0;
+					for (kk=0;kk+4<=nr;kk+=4)
+					{
+						s0=s0 + zi[kk]*zj[kk];
+						s1=s1 + zi[kk+1]*zj[kk+1];
+						s2=s2 + zi[kk+2]*zj[kk+2];
+						s3=s3 + zi[kk+3]*zj[kk+3];
+					}
+					for (;kk<nr;kk++) s0=s0 + zi[kk]*zj[kk];
+					acc[ii][jj]=acc[ii][jj] + ((s0 + s1) + (s2 + s3));
+				}
+			}
+		}
+
+		for (ii=0;ii<ni;ii++)
+		{
+			for (jj=(bi == bj) ? ii : 0;jj<nj;jj++)
+			{
+				rr=acc[ii][jj];
+				if (rr > 1.0) rr=1.0;
+				if (rr < -1.0) rr=-1.0;
+				work->corr[(ci+ii)*work->numY + cj+jj]=rr;
+				work->corr[(cj+jj)*work->numY + ci+ii]=rr;
+			}
+		}
+	}
+}
+
+#ifdef _HPUX_SOURCE
+	long corrMatrix (double *ydata, long num, long numY, long nThreads, double *corr)
+#else
+	DllExport long __cdecl corrMatrix (double *ydata, long num, long numY, long nThreads, double *corr)
+#endif
+{
+	corrWork work[TDS_MAX_THREADS];
+	double *zdata, *scale, *yy, *zz, mean, sum, dd;
+	long ii, ch, tt, numBlocks, result;
+
+	for (ii=0;ii<numY*numY;ii++)corr[ii]=0.0;
+
+	if (num < 2 || numY < 1)return -1;
+
+	zdata=(double *)malloc(num*numY*sizeof(double));
+	scale=(double *)malloc(numY*sizeof(double));
+	if (zdata == NULL || scale == NULL)
+	{
+		free(zdata);
+		free(scale);
+		return -3;
+	}
+
+	/* mean and norm of each channel, about the first value, then (y - mean)/norm */
+	result=0;
+	for (ch=0;ch<numY;ch++)
+	{
+		yy=ydata + ch*num;
+		zz=zdata + ch*num;
+		sum=0.0;
+		for (ii=0;ii<num;ii++) sum=sum + (yy[ii] - yy[0]);
+		mean=yy[0] + sum/(double)num;
+
+		sum=0.0;
+		for (ii=0;ii<num;ii++)
+		{
+			dd=yy[ii] - mean;
+			sum=sum + dd*dd;
+		}
+		if (sum > 0.0) scale[ch]=1.0/sqrt(sum);
+		else
+		{
+			scale[ch]=0.0;
+			result=-2;
+		}
+		for (ii=0;ii<num;ii++) zz[ii]=(yy[ii] - mean)*scale[ch];
+	}
+
+	numBlocks=(numY + CORR_BLOCK - 1)/CORR_BLOCK;
+	nThreads=tdsNumThreads(nThreads);
+	if (nThreads > numBlocks*(numBlocks+1)/2) nThreads=numBlocks*(numBlocks+1)/2;
+
+	for (tt=0;tt<nThreads;tt++)
+	{
+		work[tt].zdata=zdata;
+		work[tt].num=num;
+		work[tt].numY=numY;
+		work[tt].corr=corr;
+		work[tt].first=tt;
+		work[tt].step=nThreads;
+		work[tt].numBlocks=numBlocks;
+	}
+
+	tdsRunThreads(nThreads,corrWorker,work,sizeof(corrWork));
+
+	/* sums of squares of the standardized channels are 1 up to rounding */
+	for (ch=0;ch<numY;ch++) corr[ch*numY+ch]=(scale[ch] > 0.0) ? 1.0 : 0.0;
+
+	free(zdata);
+	free(scale);
+
+	return result;
+}
+
+/* ============= sortDoublePtr ========================== */
+
+/* Modified to run on PC platform. Nuri Cankurt July 2, 2003 */
+
+/* This function sorts a given double array 'fdata' to create
+   a pointer array 'index'.  It does not change 'fdata' in any way.
+
+   The sorted values of 'fdata' would be:
+   fdata[index[0]], fdata[index[1]], fdata[index[2]] ....
+
+   assending or descending.
+
+   Written by: N. Cankurt 10-30-97
+   
+   Input variables:
+   fdata  = data
+   num    = how many values are there in fdata.
+   how   = how to sort 'a' for ascending and 'd' for descending
+
+   Returned variables:
+   index  = contains the index of fdata which would be in sorted order
 
    Function returns 0 if there is no error.  -1 if there is an error
 
-   Bug fixed;  Nuri 4-24-2007 for descending flag
+   Bug fixed;  Nuri 4-24-2007 for descending flag
+
+*/
+#ifdef _HPUX_SOURCE
+	long sortDoublePtr (double *fdata, long num, char how, long *index)
+#else
+	DllExport long __cdecl sortDoublePtr (double *fdata, long num, char how, long *index)
+#endif
+{
+	long ii,jj,noswap;
+	double temp;
+	char chow;
+
+	if (num < 1)return(-1);
+//	if (how != 'A' && how != 'a' && how != 'B' && how != 'b')return -1;	  // this has a bug Nuri  4-24-2007
+	if (how != 'A' && how != 'a' && how != 'D' && how != 'd')return -1;	  // fixed the bug  4-24-2007
+
+	for (ii=0;ii<num;ii++)index[ii]=ii;
+	if (num == 1)return(0);
+
+	chow=how;
+	if (chow == 'A')chow='a';
+	if (chow == 'D')chow='d';
+
+	switch (chow)
+	{
+		case 'a':   /* assending */
+        for (ii=0;ii<num-1;ii++)
+		{
+			noswap=1;
+			for (jj=num-1;jj>ii;jj--)
+			{
+				if (fdata[index[jj]]<fdata[index[jj-1]])
+				{
+					temp=(double)index[jj];
+					index[jj]=index[jj-1];
+					index[jj-1]=(int)temp;
+					noswap=0;
+				}
+			}
+			if (noswap) return(0);
+        }
+		return (0);
+
+		case 'd':   /* descending */
+		for (ii=0;ii<num-1;ii++)
+		{
+			noswap=1;
+			for (jj=num-1;jj>ii;jj--)
+			{
+				if (fdata[index[jj]]>fdata[index[jj-1]])
+				{
+					temp=(double)index[jj];
+					index[jj]=index[jj-1];
+					index[jj-1]=(int)temp;
+					noswap=0;
+				}
+			}
+			if (noswap) return(0);
+		}
+		return (0);
+	}
+	return (-1);
+}
+
+/********************************************************************************************/
+/*																							*/
+/* sortDoubleRadix: This function sorts an index to 'fdata', like sortDoublePtr, with an	*/
+/*  LSD radix sort in O(num) for large arrays.												*/
+/*																							*/
+/*  Each value is turned into a 64 bit key that sorts as unsigned integers in the same		*/
+/*  order as the doubles (sign bit flipped for positive values, all bits flipped for		*/
+/*  negative ones; inverted again for descending order).  The keys are sorted 11 bits at a	*/
+/*  time with 32 bit indices, and passes where all keys share the same digit are skipped.	*/
+/*  The sort is stable: equal values (including -0 and +0) keep their original order, as	*/
+/*  with sortDoublePtr.  NaNs are placed last, in their original order, for both 'a' and	*/
+/*  'd'.  Arrays of fewer than RADIX_MIN_NUM values are insertion sorted.					*/
+/*																							*/
+/*  fdata: num values to sort (not changed)													*/
+/*  how: 'a' or 'A' for ascending, 'd' or 'D' for descending								*/
+/*  index: returned num indices to fdata in sorted order									*/
+/*																							*/
+/*  sortDoubleRadix_i32 is the same with 32 bit (int) indices, which halves the memory		*/
+/*  traffic of the index where long is 64 bits.												*/
+/*																							*/
+/*  The 32 bit indices limit num to UINT_MAX (4294967295) values for sortDoubleRadix and	*/
+/*  to INT_MAX (2147483647) for sortDoubleRadix_i32.										*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1, num is over the limit or 'how' is not	*/
+/*  valid, -3 if out of memory																*/
+/********************************************************************************************/
+#define RADIX_BITS		11
+#define RADIX_SIZE		(1 << RADIX_BITS)
+#define RADIX_PASSES	6			/* 6 x 11 >= 64 bits */
+#define RADIX_MIN_NUM	64
+
+/* ordered key of fdata, descending if 'desc'; NaN sorts last */
+static tdsUInt64 radixKey (double val, int desc)
+{
+	tdsUInt64 bits;
+
+	if (val != val)return ~(tdsUInt64)0;
+	if (val == 0.0) val=0.0;		/* -0 -> +0 */
+
+	memcpy(&bits,&val,sizeof(bits));
+	if (bits >> 63) bits=~bits;
+	else bits=bits | ((tdsUInt64)1 << 63);
+
+	return desc ? ~bits : bits;
+}
+
+/* sorts 'index' (num values, 32 bit) by the keys of fdata */
+static long radixArgsort (double *fdata, long num, char how, unsigned int *dest)
+{
+	tdsUInt64 *keys, *keys2, *ktmp, key;
+	unsigned int *index, *idx2, *itmp, ival;
+	long *count, pass, ii, jj, sum, cc;
+	int desc, shift;
+
+	if (num < 1)return -1;
+	if ((tdsUInt64)num > (tdsUInt64)UINT_MAX)return -1;	/* indices would wrap */
+	if (how == 'A' || how == 'a') desc=0;
+	else if (how == 'D' || how == 'd') desc=1;
+	else return -1;
+
+	keys=(tdsUInt64 *)malloc(num*sizeof(tdsUInt64));
+	if (keys == NULL)return -3;
+	index=dest;
+	for (ii=0;ii<num;ii++)
+	{
+		keys[ii]=radixKey(fdata[ii],desc);
+		index[ii]=(unsigned int)ii;
+	}
+
+	if (num < RADIX_MIN_NUM)
+	{
+		for (ii=1;ii<num;ii++)
+		{
+			key=keys[ii];
+			ival=index[ii];
+			for (jj=ii;jj>0 && keys[jj-1]>key;jj--)
+			{
+				keys[jj]=keys[jj-1];
+				index[jj]=index[jj-1];
+			}
+			keys[jj]=key;
+			index[jj]=ival;
+		}
+		free(keys);
+		return 0;
+	}
+
+	keys2=(tdsUInt64 *)malloc(num*sizeof(tdsUInt64));
+	idx2=(unsigned int *)malloc(num*sizeof(unsigned int));
+	count=(long *)calloc(RADIX_PASSES*RADIX_SIZE,sizeof(long));
+	if (keys2 == NULL || idx2 == NULL || count == NULL)
+	{
+		free(keys);
+		free(keys2);
+		free(idx2);
+		free(count);
+		return -3;
+	}
+
+	/* histograms of all digits in one pass */
+	for (ii=0;ii<num;ii++)
+	{
+		key=keys[ii];
+		for (pass=0;pass<RADIX_PASSES;pass++)
+		{
+			count[pass*RADIX_SIZE + (long)((key >> (pass*RADIX_BITS)) & (RADIX_SIZE-1))]++;
+		}
+	}
+
+	for (pass=0;pass<RADIX_PASSES;pass++)
+	{
+		shift=(int)(pass*RADIX_BITS);
+
+		/* skip the pass if every key has the same digit */
+		if (count[pass*RADIX_SIZE + (long)((keys[0] >> shift) & (RADIX_SIZE-1))] == num)continue;
+
+		sum=0;
+		for (jj=0;jj<RADIX_SIZE;jj++)
+		{
+			cc=count[pass*RADIX_SIZE + jj];
+			count[pass*RADIX_SIZE + jj]=sum;
+			sum=sum + cc;
+		}
+
+		for (ii=0;ii<num;ii++)
+		{
+			jj=count[pass*RADIX_SIZE + (long)((keys[ii] >> shift) & (RADIX_SIZE-1))]++;
+			keys2[jj]=keys[ii];
+			idx2[jj]=index[ii];
+		}
+
+		ktmp=keys; keys=keys2; keys2=ktmp;
+		itmp=index; index=idx2; idx2=itmp;
+	}
+
+	/* after an odd number of passes the result is in the work array */
+	if (index != dest)
+	{
+		memcpy(dest,index,num*sizeof(unsigned int));
+		idx2=index;
+	}
+
+	free(keys);
+	free(keys2);
+	free(idx2);
+	free(count);
+	return 0;
+}
+
+#ifdef _HPUX_SOURCE
+	long sortDoubleRadix (double *fdata, long num, char how, long *index)
+#else
+	DllExport long __cdecl sortDoubleRadix (double *fdata, long num, char how, long *index)
+#endif
+{
+	unsigned int *idx32;
+	long ii, result;
+
+	/* a long index can hold the 32 bit one in place only if long is 32 bits */
+	if (sizeof(long) == sizeof(unsigned int))return radixArgsort(fdata,num,how,(unsigned int *)index);
+
+	if (num < 1 || (tdsUInt64)num > (tdsUInt64)UINT_MAX)return -1;
+	idx32=(unsigned int *)malloc(num*sizeof(unsigned int));
+	if (idx32 == NULL)return -3;
+
+	result=radixArgsort(fdata,num,how,idx32);
+	if (result == 0) for (ii=0;ii<num;ii++)index[ii]=(long)idx32[ii];
+
+	free(idx32);
+	return result;
+}
+
+#ifdef _HPUX_SOURCE
+	long sortDoubleRadix_i32 (double *fdata, long num, char how, int *index)
+#else
+	DllExport long __cdecl sortDoubleRadix_i32 (double *fdata, long num, char how, int *index)
+#endif
+{
+	if ((tdsUInt64)num > (tdsUInt64)INT_MAX)return -1;
+
+	return radixArgsort(fdata,num,how,(unsigned int *)index);
+}
+
+/********************************************************************************************/
+/*																							*/
+/* sortDoublePtr_par: This function sorts an index to 'fdata', like sortDoublePtr, on		*/
+/*  several threads.																		*/
+/*																							*/
+/*  The values are turned into ordered 64 bit keys as in sortDoubleRadix.  Each thread		*/
+/*  merge sorts one chunk of the array, then the sorted chunks are merged pairwise in		*/
+/*  rounds.  In every round the output is cut into equal parts, one per thread, and each	*/
+/*  thread finds where its part starts in the two input runs by binary search (merge		*/
+/*  path), so all threads stay busy up to the last merge.  All merges are stable, so the	*/
+/*  result is the same permutation as sortDoubleRadix (and sortDoublePtr) for any			*/
+/*  'nThreads'.  NaNs are placed last, in their original order.								*/
+/*																							*/
+/*  fdata: num values to sort (not changed)													*/
+/*  how: 'a' or 'A' for ascending, 'd' or 'D' for descending								*/
+/*  index: returned num indices to fdata in sorted order									*/
+/*  nThreads: number of threads, 0 for one per CPU											*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1 or 'how' is not valid, -3 if out of		*/
+/*  memory																					*/
+/********************************************************************************************/
+#define PSORT_MIN_CHUNK		8192
+
+typedef struct
+{
+	tdsUInt64	*keys;		/* input keys and indices of this step */
+	long		*idx;
+	tdsUInt64	*keysOut;	/* output of this step */
+	long		*idxOut;
+	long		*bounds;	/* run boundaries, numRuns+1 values */
+	long		numRuns;
+	long		outStart;	/* part of the output done by this thread */
+	long		outEnd;
+} psortWork;
+
+/* stable merge of a[0..na) and b[0..nb) */
+static void psortMerge (const tdsUInt64 *ka, const long *ia, long na, const tdsUInt64 *kb, const long *ib, long nb, tdsUInt64 *ko, long *io)
+{
+	long aa, bb, kk;
+
+	aa=0;
+	bb=0;
+	kk=0;
+	while (aa < na && bb < nb)
+	{
+		if (kb[bb] < ka[aa])
+		{
+			ko[kk]=kb[bb];
+			io[kk++]=ib[bb++];
+		}
+		else
+		{
+			ko[kk]=ka[aa];
+			io[kk++]=ia[aa++];
+		}
+	}
+	for (;aa<na;aa++,kk++)
+	{
+		ko[kk]=ka[aa];
+		io[kk]=ia[aa];
+	}
+	for (;bb<nb;bb++,kk++)
+	{
+		ko[kk]=kb[bb];
+		io[kk]=ib[bb];
+	}
+}
+
+/* number of values taken from a[] among the first kk outputs of the stable merge */
+static long psortCorank (const tdsUInt64 *ka, long na, const tdsUInt64 *kb, long nb, long kk)
+{
+	long lo, hi, mid;
+
+	lo=(kk - nb > 0) ? kk - nb : 0;
+	hi=(kk < na) ? kk : na;
+	while (lo < hi)
+	{
+		mid=lo + (hi - lo)/2;
+		if (ka[mid] <= kb[kk - mid - 1]) lo=mid + 1;
+		else hi=mid;
+	}
+	return lo;
+}
+
+/* merge sort of one chunk, result in keys/idx */
+static void psortChunkWorker (void *arg)
+{
+	psortWork *work;
+	tdsUInt64 *src, *dst, *ktmp;
+	long *isrc, *idst, *itmp;
+	long first, num, width, left, mid, right;
+
+	work=(psortWork *)arg;
+	first=work->outStart;
+	num=work->outEnd - first;
+
+	src=work->keys + first;
+	isrc=work->idx + first;
+	dst=work->keysOut + first;
+	idst=work->idxOut + first;
+	for (width=1;width<num;width*=2)
+	{
+		for (left=0;left<num;left+=2*width)
+		{
+			mid=(left + width < num) ? left + width : num;
+			right=(left + 2*width < num) ? left + 2*width : num;
+			psortMerge(src+left,isrc+left,mid-left,src+mid,isrc+mid,right-mid,dst+left,idst+left);
+		}
+		ktmp=src; src=dst; dst=ktmp;
+		itmp=isrc; isrc=idst; idst=itmp;
+	}
+	if (src != work->keys + first)
+	{
+		memcpy(work->keys+first,src,num*sizeof(tdsUInt64));
+		memcpy(work->idx+first,isrc,num*sizeof(long));
+	}
+}
+
+/* merges the pairs of runs overlapping outStart..outEnd of the output */
+static void psortMergeWorker (void *arg)
+{
+	psortWork *work;
+	long pp, start, mid, end, k0, k1, i0, i1;
+
+	work=(psortWork *)arg;
+	for (pp=0;pp<work->numRuns;pp+=2)
+	{
+		start=work->bounds[pp];
+		mid=work->bounds[pp+1];
+		end=(pp + 2 <= work->numRuns) ? work->bounds[pp+2] : mid;
+		if (end <= work->outStart || start >= work->outEnd)continue;
+
+		k0=((work->outStart > start) ? work->outStart : start) - start;
+		k1=((work->outEnd < end) ? work->outEnd : end) - start;
+		i0=psortCorank(work->keys+start,mid-start,work->keys+mid,end-mid,k0);
+		i1=psortCorank(work->keys+start,mid-start,work->keys+mid,end-mid,k1);
+
+		psortMerge(work->keys+start+i0,work->idx+start+i0,i1-i0,
+			work->keys+mid+(k0-i0),work->idx+mid+(k0-i0),(k1-i1)-(k0-i0),
+			work->keysOut+start+k0,work->idxOut+start+k0);
+	}
+}
+
+#ifdef _HPUX_SOURCE
+	long sortDoublePtr_par (double *fdata, long num, char how, long *index, long nThreads)
+#else
+	DllExport long __cdecl sortDoublePtr_par (double *fdata, long num, char how, long *index, long nThreads)
+#endif
+{
+	psortWork work[TDS_MAX_THREADS];
+	tdsUInt64 *keys, *keys2, *ktmp;
+	long *idx, *idx2, *itmp, *bounds;
+	long ii, tt, numRuns;
+	int desc;
+
+	if (num < 1)return -1;
+	if (how == 'A' || how == 'a') desc=0;
+	else if (how == 'D' || how == 'd') desc=1;
+	else return -1;
+
+	nThreads=tdsNumThreads(nThreads);
+	if (nThreads > num/PSORT_MIN_CHUNK) nThreads=num/PSORT_MIN_CHUNK;
+	if (nThreads < 1) nThreads=1;
+
+	keys=(tdsUInt64 *)malloc(num*sizeof(tdsUInt64));
+	keys2=(tdsUInt64 *)malloc(num*sizeof(tdsUInt64));
+	idx2=(long *)malloc(num*sizeof(long));
+	bounds=(long *)malloc((nThreads+1)*sizeof(long));
+	if (keys == NULL || keys2 == NULL || idx2 == NULL || bounds == NULL)
+	{
+		free(keys);
+		free(keys2);
+		free(idx2);
+		free(bounds);
+		return -3;
+	}
+
+	idx=index;
+	for (ii=0;ii<num;ii++)
+	{
+		keys[ii]=radixKey(fdata[ii],desc);
+		idx[ii]=ii;
+	}
+
+	/* sorted chunks, one per thread */
+	for (tt=0;tt<=nThreads;tt++) bounds[tt]=(long)(((double)num*tt)/nThreads);
+	for (tt=0;tt<nThreads;tt++)
+	{
+		work[tt].keys=keys;
+		work[tt].idx=idx;
+		work[tt].keysOut=keys2;
+		work[tt].idxOut=idx2;
+		work[tt].outStart=bounds[tt];
+		work[tt].outEnd=bounds[tt+1];
+	}
+	tdsRunThreads(nThreads,psortChunkWorker,work,sizeof(psortWork));
+
+	/* merge rounds, each thread writes an equal part of the output */
+	numRuns=nThreads;
+	while (numRuns > 1)
+	{
+		for (tt=0;tt<nThreads;tt++)
+		{
+			work[tt].keys=keys;
+			work[tt].idx=idx;
+			work[tt].keysOut=keys2;
+			work[tt].idxOut=idx2;
+			work[tt].bounds=bounds;
+			work[tt].numRuns=numRuns;
+			work[tt].outStart=(long)(((double)num*tt)/nThreads);
+			work[tt].outEnd=(long)(((double)num*(tt+1))/nThreads);
+		}
+		tdsRunThreads(nThreads,psortMergeWorker,work,sizeof(psortWork));
+
+		for (ii=0;2*ii<numRuns;ii++) bounds[ii]=bounds[2*ii];
+		bounds[ii]=num;
+		numRuns=ii;
+
+		ktmp=keys; keys=keys2; keys2=ktmp;
+		itmp=idx; idx=idx2; idx2=itmp;
+	}
+
+	/* after an odd number of rounds the result is in the work array */
+	if (idx != index)
+	{
+		memcpy(index,idx,num*sizeof(long));
+		idx2=idx;
+	}
+
+	free(keys);
+	free(keys2);
+	free(idx2);
+	free(bounds);
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* sortDoubleAdaptive: This function sorts an index to 'fdata', like sortDoublePtr, in		*/
+/*  close to O(num) time for nearly sorted data (time stamps with a few late samples,		*/
+/*  monotone ramps up or down), and O(num log num) in general.								*/
+/*																							*/
+/*  The data is scanned for natural runs: non-descending runs are taken as they are and		*/
+/*  strictly descending runs are reversed (strict, so equal values keep their order).		*/
+/*  Runs shorter than ADAPT_MIN_RUN are extended by binary insertion.  Runs are merged in	*/
+/*  the order given by their powersort node power, which keeps the merges balanced, and		*/
+/*  each merge first skips the parts of both runs that are already in place, so a run		*/
+/*  with a few late values costs little more than a copy of the overlap.  The keys are		*/
+/*  those of sortDoubleRadix, so the result is the same stable permutation, with NaNs last.	*/
+/*																							*/
+/*  fdata: num values to sort (not changed)													*/
+/*  how: 'a' or 'A' for ascending, 'd' or 'D' for descending								*/
+/*  index: returned num indices to fdata in sorted order									*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1 or 'how' is not valid, -3 if out of		*/
+/*  memory																					*/
+/********************************************************************************************/
+#define ADAPT_MIN_RUN		32
+#define ADAPT_MAX_STACK		80
+
+typedef struct
+{
+	long	start;
+	long	len;
+	int		power;
+} adaptRun;
+
+/* powersort node power of the boundary between runs s1..s1+n1 and s1+n1..s1+n1+n2 */
+static int adaptPower (long s1, long n1, long n2, long num)
+{
+	double aa, bb, nn;
+	int power;
+
+	aa=2.0*s1 + n1;
+	bb=aa + n1 + n2;
+	nn=(double)num;
+	power=0;
+	while (1)
+	{
+		power++;
+		if (aa >= nn)
+		{
+			aa=aa - nn;
+			bb=bb - nn;
+		}
+		else if (bb >= nn)break;
+		aa=aa*2.0;
+		bb=bb*2.0;
+	}
+	return power;
+}
+
+/* first position in keys[0..num) whose key is > key (upper bound) */
+static long adaptUpper (const tdsUInt64 *keys, long num, tdsUInt64 key)
+{
+	long lo, hi, mid;
+
+	lo=0;
+	hi=num;
+	while (lo < hi)
+	{
+		mid=lo + (hi - lo)/2;
+		if (keys[mid] <= key) lo=mid + 1;
+		else hi=mid;
+	}
+	return lo;
+}
+
+/* first position in keys[0..num) whose key is >= key (lower bound) */
+static long adaptLower (const tdsUInt64 *keys, long num, tdsUInt64 key)
+{
+	long lo, hi, mid;
+
+	lo=0;
+	hi=num;
+	while (lo < hi)
+	{
+		mid=lo + (hi - lo)/2;
+		if (keys[mid] < key) lo=mid + 1;
+		else hi=mid;
+	}
+	return lo;
+}
+
+/* stable merge of the adjacent runs [s1,s1+n1) and [s1+n1,s1+n1+n2) */
+static void adaptMerge (tdsUInt64 *keys, long *idx, tdsUInt64 *tkeys, long *tidx, long s1, long n1, long n2)
+{
+	tdsUInt64 *ka, *kb;
+	long *ia, *ib;
+	long skip, aa, bb, kk;
+
+	ka=keys + s1;
+	kb=keys + s1 + n1;
+
+	/* values of A not above B[0] and values of B not below A's last are in place */
+	skip=adaptUpper(ka,n1,kb[0]);
+	s1=s1 + skip;
+	n1=n1 - skip;
+	if (n1 == 0)return;
+	ka=keys + s1;
+	n2=adaptLower(kb,n2,ka[n1-1]);
+	if (n2 == 0)return;
+
+	ia=idx + s1;
+	ib=idx + s1 + n1;
+
+	if (n1 <= n2)
+	{
+		/* A to the buffer, merge from the front */
+		memcpy(tkeys,ka,n1*sizeof(tdsUInt64));
+		memcpy(tidx,ia,n1*sizeof(long));
+		aa=0;
+		bb=0;
+		kk=0;
+		while (aa < n1 && bb < n2)
+		{
+			if (kb[bb] < tkeys[aa])
+			{
+				ka[kk]=kb[bb];
+				ia[kk++]=ib[bb++];
+			}
+			else
+			{
+				ka[kk]=tkeys[aa];
+				ia[kk++]=tidx[aa++];
+			}
+		}
+		for (;aa<n1;aa++,kk++)
+		{
+			ka[kk]=tkeys[aa];
+			ia[kk]=tidx[aa];
+		}
+	}
+	else
+	{
+		/* B to the buffer, merge from the back */
+		memcpy(tkeys,kb,n2*sizeof(tdsUInt64));
+		memcpy(tidx,ib,n2*sizeof(long));
+		aa=n1 - 1;
+		bb=n2 - 1;
+		kk=n1 + n2 - 1;
+		while (aa >= 0 && bb >= 0)
+		{
+			if (tkeys[bb] < ka[aa])
+			{
+				ka[kk]=ka[aa];
+				ia[kk--]=ia[aa--];
+			}
+			else
+			{
+				ka[kk]=tkeys[bb];
+				ia[kk--]=tidx[bb--];
+			}
+		}
+		for (;bb>=0;bb--,kk--)
+		{
+			ka[kk]=tkeys[bb];
+			ia[kk]=tidx[bb];
+		}
+	}
+}
+
+#ifdef _HPUX_SOURCE
+	long sortDoubleAdaptive (double *fdata, long num, char how, long *index)
+#else
+	DllExport long __cdecl sortDoubleAdaptive (double *fdata, long num, char how, long *index)
+#endif
+{
+	adaptRun stack[ADAPT_MAX_STACK];
+	tdsUInt64 *keys, *tkeys, key;
+	long *tidx, ii, jj, end, lo, hi, ival, nStack;
+	int desc, power;
+
+	if (num < 1)return -1;
+	if (how == 'A' || how == 'a') desc=0;
+	else if (how == 'D' || how == 'd') desc=1;
+	else return -1;
+
+	keys=(tdsUInt64 *)malloc(num*sizeof(tdsUInt64));
+	tkeys=(tdsUInt64 *)malloc((num/2+1)*sizeof(tdsUInt64));
+	tidx=(long *)malloc((num/2+1)*sizeof(long));
+	if (keys == NULL || tkeys == NULL || tidx == NULL)
+	{
+		free(keys);
+		free(tkeys);
+		free(tidx);
+		return -3;
+	}
+
+	for (ii=0;ii<num;ii++)
+	{
+		keys[ii]=radixKey(fdata[ii],desc);
+		index[ii]=ii;
+	}
+
+	nStack=0;
+	for (ii=0;ii<num;ii=end)
+	{
+		/* natural run starting at ii */
+		end=ii + 1;
+		if (end < num && keys[end] < keys[ii])
+		{
+			while (end < num && keys[end] < keys[end-1]) end++;
+			for (lo=ii,hi=end-1;lo<hi;lo++,hi--)
+			{
+				key=keys[lo]; keys[lo]=keys[hi]; keys[hi]=key;
+				ival=index[lo]; index[lo]=index[hi]; index[hi]=ival;
+			}
+		}
+		else
+		{
+			while (end < num && keys[end] >= keys[end-1]) end++;
+		}
+
+		/* short run: extend by binary insertion */
+		if (end - ii < ADAPT_MIN_RUN && end < num)
+		{
+			hi=(num - ii < ADAPT_MIN_RUN) ? num : ii + ADAPT_MIN_RUN;
+			for (;end<hi;end++)
+			{
+				key=keys[end];
+				ival=index[end];
+				lo=ii + adaptUpper(keys+ii,end-ii,key);
+				for (jj=end;jj>lo;jj--)
+				{
+					keys[jj]=keys[jj-1];
+					index[jj]=index[jj-1];
+				}
+				keys[lo]=key;
+				index[lo]=ival;
+			}
+		}
+
+		/* merge runs whose boundary is deeper than the new one */
+		if (nStack > 0)
+		{
+			power=adaptPower(stack[nStack-1].start,stack[nStack-1].len,end-ii,num);
+			while (nStack > 1 && stack[nStack-2].power > power)
+			{
+				adaptMerge(keys,index,tkeys,tidx,stack[nStack-2].start,stack[nStack-2].len,stack[nStack-1].len);
+				stack[nStack-2].len=stack[nStack-2].len + stack[nStack-1].len;
+				nStack--;
+			}
+			stack[nStack-1].power=power;
+		}
+		stack[nStack].start=ii;
+		stack[nStack].len=end - ii;
+		stack[nStack].power=0;
+		nStack++;
+	}
+
+	while (nStack > 1)
+	{
+		adaptMerge(keys,index,tkeys,tidx,stack[nStack-2].start,stack[nStack-2].len,stack[nStack-1].len);
+		stack[nStack-2].len=stack[nStack-2].len + stack[nStack-1].len;
+		nStack--;
+	}
+
+	free(keys);
+	free(tkeys);
+	free(tidx);
+	return 0;
+}
+
+/* ============= sort helpers =========================== */
+/*																*/
+/* tdsMergeArgsort: stable ascending argsort by key1, then key2	*/
+/*	(key2 may be NULL).  Same order as sortDoublePtr 'a' but		*/
+/*	O(num log num).  'work' holds num values.					*/
+/*																*/
+/* tdsSelect: returns the k-th smallest (0 based) of data[],	*/
+/*	which is reordered so that data[0..k-1] <= data[k] <=		*/
+/*	data[k+1..] (Floyd-Rivest select, O(num) expected).  data	*/
+/*	must not hold NaNs.											*/
+/****************************************************************/
+static int tdsKeyLess (const double *key1, const double *key2, long aa, long bb)
+{
+	if (key1[aa] < key1[bb])return 1;
+	if (key1[aa] > key1[bb] || key2 == NULL)return 0;
+	return key2[aa] < key2[bb];
+}
+
+static void tdsMergeArgsort (const double *key1, const double *key2, long num, long *index, long *work)
+{
+	long ii, width, left, mid, right, aa, bb, kk;
+	long *src, *dst, *tmp;
+
+	for (ii=0;ii<num;ii++)index[ii]=ii;
+
+	src=index;
+	dst=work;
+	for (width=1;width<num;width*=2)
+	{
+		for (left=0;left<num;left+=2*width)
+		{
+			mid=(left + width < num) ? left + width : num;
+			right=(left + 2*width < num) ? left + 2*width : num;
+			aa=left;
+			bb=mid;
+			kk=left;
+			while (aa < mid && bb < right)
+			{
+				if (tdsKeyLess(key1,key2,src[bb],src[aa])) dst[kk++]=src[bb++];
+				else dst[kk++]=src[aa++];
+			}
+			while (aa < mid) dst[kk++]=src[aa++];
+			while (bb < right) dst[kk++]=src[bb++];
+		}
+		tmp=src;
+		src=dst;
+		dst=tmp;
+	}
+	if (src != index) memcpy(index,src,num*sizeof(long));
+}
+
+static void tdsSelectRange (double *data, long left, long right, long kk)
+{
+	long ii, jj, nn, newLeft, newRight;
+	double zz, ss, sd, pivot, temp;
+
+	while (right > left)
+	{
+		/* narrow to a sample range that holds the k-th value with high probability */
+		if (right - left > 600)
+		{
+			nn=right - left + 1;
+			ii=kk - left + 1;
+			zz=log((double)nn);
+			ss=0.5*exp(2.0*zz/3.0);
+			sd=0.5*sqrt(zz*ss*(nn - ss)/nn);
+			if (ii < nn/2) sd=-sd;
+			newLeft=(long)(kk - ii*ss/nn + sd);
+			newRight=(long)(kk + (nn - ii)*ss/nn + sd);
+			if (newLeft < left) newLeft=left;
+			if (newRight > right) newRight=right;
+			tdsSelectRange(data,newLeft,newRight,kk);
+		}
+
+		pivot=data[kk];
+		ii=left;
+		jj=right;
+		temp=data[left]; data[left]=data[kk]; data[kk]=temp;
+		if (data[right] > pivot)
+		{
+			temp=data[right]; data[right]=data[left]; data[left]=temp;
+		}
+		while (ii < jj)
+		{
+			temp=data[ii]; data[ii]=data[jj]; data[jj]=temp;
+			ii++;
+			jj--;
+			while (data[ii] < pivot) ii++;
+			while (data[jj] > pivot) jj--;
+		}
+		if (data[left] == pivot)
+		{
+			temp=data[left]; data[left]=data[jj]; data[jj]=temp;
+		}
+		else
+		{
+			jj++;
+			temp=data[jj]; data[jj]=data[right]; data[right]=temp;
+		}
+
+		if (jj <= kk) left=jj + 1;
+		if (kk <= jj) right=jj - 1;
+	}
+}
+
+static double tdsSelect (double *data, long num, long kk)
+{
+	tdsSelectRange(data,0,num-1,kk);
+	return data[kk];
+}
+
+/* median of data[] (reordered), mean of the two middle values if num is even */
+static double tdsMedian (double *data, long num)
+{
+	double lower, upper;
+	long ii;
+
+	upper=tdsSelect(data,num,num/2);
+	if (num % 2)return upper;
+
+	lower=data[0];
+	for (ii=1;ii<num/2;ii++) if (data[ii] > lower) lower=data[ii];
+
+	return 0.5*(lower + upper);
+}
+
+/* copy of data[] without NaNs, returns the number copied */
+static long selectCopy (const double *data, long num, double *copy)
+{
+	long ii, nn;
+
+	nn=0;
+	for (ii=0;ii<num;ii++) if (data[ii] == data[ii]) copy[nn++]=data[ii];
+	return nn;
+}
+
+/* places the values of ranks[rlo..rhi] (ascending) at their rank in data[lo..hi] */
+static void selectMulti (double *data, long lo, long hi, const long *ranks, long rlo, long rhi)
+{
+	long rm;
+
+	while (rlo <= rhi && lo < hi)
+	{
+		/* the middle rank splits both the data and the remaining ranks */
+		rm=rlo + (rhi - rlo)/2;
+		tdsSelectRange(data,lo,hi,ranks[rm]);
+		selectMulti(data,lo,ranks[rm]-1,ranks,rlo,rm-1);
+		lo=ranks[rm] + 1;
+		rlo=rm + 1;
+	}
+}
+
+/********************************************************************************************/
+/*																							*/
+/* selectNth: This function returns the value at position 'nth' (0 based) of 'data' sorted	*/
+/*  in ascending order, without sorting (Floyd-Rivest select, O(num) expected).  NaNs sort	*/
+/*  last, as with sortDoubleRadix.  'data' is not changed.									*/
+/*																							*/
+/*  value: returned value																	*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1 or nth is not in 0..num-1, -3 if out of	*/
+/*  memory																					*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long selectNth (double *data, long num, long nth, double *value)
+#else
+	DllExport long __cdecl selectNth (double *data, long num, long nth, double *value)
+#endif
+{
+	double *copy;
+	long ii, nn;
+
+	*value=0.0;
+	if (num < 1 || nth < 0 || nth >= num)return -1;
+
+	copy=(double *)malloc(num*sizeof(double));
+	if (copy == NULL)return -3;
+
+	nn=selectCopy(data,num,copy);
+	if (nth < nn) *value=tdsSelect(copy,nn,nth);
+	else
+	{
+		for (ii=0;ii<num;ii++) if (data[ii] != data[ii]) *value=data[ii];
+	}
+
+	free(copy);
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* topK: This function returns the indices of the 'kk' smallest ('a') or largest ('d')		*/
+/*  values of 'data', in sorted order.  The result is the first kk entries of the index		*/
+/*  from sortDoubleRadix (or sortDoublePtr): ties keep their original order and NaNs come	*/
+/*  last.  The k-th value is found by selection, the kk values are gathered in one scan		*/
+/*  and only they are sorted, in O(num + kk log kk).  'data' is not changed.				*/
+/*																							*/
+/*  how: 'a' or 'A' for the smallest, 'd' or 'D' for the largest							*/
+/*  index: returned kk indices to data														*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1, kk is not in 1..num or 'how' is not		*/
+/*  valid, -3 if out of memory																*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long topK (double *data, long num, long kk, char how, long *index)
+#else
+	DllExport long __cdecl topK (double *data, long num, long kk, char how, long *index)
+#endif
+{
+	double *copy, *vals, limit;
+	long *perm, ii, nn, kv, numEqual, numOut, result;
+	int desc;
+
+	if (num < 1 || kk < 1 || kk > num)return -1;
+	if (how == 'A' || how == 'a') desc=0;
+	else if (how == 'D' || how == 'd') desc=1;
+	else return -1;
+
+	copy=(double *)malloc(num*sizeof(double));
+	if (copy == NULL)return -3;
+
+	nn=selectCopy(data,num,copy);
+	kv=(kk < nn) ? kk : nn;
+	numOut=0;
+	result=0;
+	if (kv > 0)
+	{
+		/* limit is the kv-th value; count how many equal to it are wanted */
+		limit=tdsSelect(copy,nn,desc ? nn-kv : kv-1);
+		numEqual=kv;
+		for (ii=0;ii<nn;ii++)
+		{
+			if (desc ? copy[ii] > limit : copy[ii] < limit) numEqual--;
+		}
+
+		for (ii=0;ii<num;ii++)
+		{
+			if (data[ii] != data[ii])continue;
+			if (desc ? data[ii] > limit : data[ii] < limit) index[numOut++]=ii;
+			else if (data[ii] == limit && numEqual > 0)
+			{
+				index[numOut++]=ii;
+				numEqual--;
+			}
+		}
+
+		/* stable sort of the kv values, gathered in index order */
+		vals=copy;
+		perm=(long *)malloc(kv*sizeof(long));
+		if (perm == NULL) result=-3;
+		else
+		{
+			for (ii=0;ii<kv;ii++) vals[ii]=data[index[ii]];
+			result=sortDoubleAdaptive(vals,kv,how,perm);
+			for (ii=0;ii<kv;ii++) perm[ii]=index[perm[ii]];
+			memcpy(index,perm,kv*sizeof(long));
+			free(perm);
+		}
+	}
+
+	/* NaNs last */
+	for (ii=0;ii<num && numOut<kk && result == 0;ii++)
+	{
+		if (data[ii] != data[ii]) index[numOut++]=ii;
+	}
+
+	free(copy);
+	return result;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* percentiles: This function returns several percentiles of 'data' without sorting.		*/
+/*  A percentile p is interpolated between the two closest ranks of the sorted values:		*/
+/*  position p/100*(n-1), where n is the number of values that are not NaN (NaNs are		*/
+/*  ignored).  All ranks needed are placed by one multiple selection: each select splits	*/
+/*  the data for the ranks below and above it, so the partitioning work is shared.			*/
+/*  'data' is not changed.																	*/
+/*																							*/
+/*  pct: np percentiles, 0 to 100															*/
+/*  out: returned np values																	*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1 or np < 1, -2 if a percentile is not in	*/
+/*  0..100 or all values are NaN, -3 if out of memory										*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long percentiles (double *data, long num, double *pct, long np, double *out)
+#else
+	DllExport long __cdecl percentiles (double *data, long num, double *pct, long np, double *out)
+#endif
+{
+	double *copy, pos, frac;
+	long *ranks, ii, jj, nn, nr, lo, rank;
+
+	for (ii=0;ii<np;ii++) out[ii]=0.0;
+	if (num < 1 || np < 1)return -1;
+	for (ii=0;ii<np;ii++) if (!(pct[ii] >= 0.0 && pct[ii] <= 100.0))return -2;
+
+	copy=(double *)malloc(num*sizeof(double));
+	ranks=(long *)malloc(2*np*sizeof(long));
+	if (copy == NULL || ranks == NULL)
+	{
+		free(copy);
+		free(ranks);
+		return -3;
+	}
+
+	nn=selectCopy(data,num,copy);
+	if (nn == 0)
+	{
+		free(copy);
+		free(ranks);
+		return -2;
+	}
+
+	/* the ranks around each position, sorted without duplicates */
+	nr=0;
+	for (ii=0;ii<np;ii++)
+	{
+		pos=pct[ii]/100.0*(nn - 1);
+		lo=(long)pos;
+		ranks[nr++]=lo;
+		ranks[nr++]=(lo + 1 < nn) ? lo + 1 : lo;
+	}
+	for (ii=1;ii<nr;ii++)
+	{
+		rank=ranks[ii];
+		for (jj=ii;jj>0 && ranks[jj-1]>rank;jj--) ranks[jj]=ranks[jj-1];
+		ranks[jj]=rank;
+	}
+	for (ii=0,jj=0;ii<nr;ii++) if (jj == 0 || ranks[ii] != ranks[jj-1]) ranks[jj++]=ranks[ii];
+	nr=jj;
+
+	selectMulti(copy,0,nn-1,ranks,0,nr-1);
+
+	for (ii=0;ii<np;ii++)
+	{
+		pos=pct[ii]/100.0*(nn - 1);
+		lo=(long)pos;
+		frac=pos - lo;
+		out[ii]=copy[lo];
+		if (frac > 0.0 && lo + 1 < nn) out[ii]=copy[lo] + frac*(copy[lo+1] - copy[lo]);
+	}
+
+	free(copy);
+	free(ranks);
+	return 0;
+}
+
+#define PERMUTE_TILE	1024	/* index entries per tile, kept in L1 across the arrays */
+
+/********************************************************************************************/
+/*																							*/
+/* permuteArrays: This function applies one permutation to several arrays:					*/
+/*  out[jj][ii]=arrays[jj][index[ii]], e.g. with the index returned by sortDoublePtr.		*/
+/*  The index is read in tiles of PERMUTE_TILE entries, and each tile is applied to all		*/
+/*  the arrays before moving on, so the index is read from memory once and the writes		*/
+/*  are sequential.																			*/
+/*  If out is NULL the arrays are permuted in place by following the cycles of the			*/
+/*  permutation; this needs only num bytes of work space instead of a second copy of		*/
+/*  every array.																			*/
+/*																							*/
+/*  index: num indices, a permutation of 0..num-1 (checked when permuting in place)			*/
+/*  arrays: nArrays arrays of num values													*/
+/*  out: nArrays arrays of num values for the results, or NULL to permute in place;			*/
+/*   out arrays must not be the same as the input arrays									*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1, nArrays < 1 or an index is out of		*/
+/*  range, -2 if index is not a permutation (in place only), -3 if out of memory			*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long permuteArrays (long *index, long num, double **arrays, long nArrays, double **out)
+#else
+	DllExport long __cdecl permuteArrays (long *index, long num, double **arrays, long nArrays, double **out)
+#endif
+{
+	double *src, *dst, *hold;
+	unsigned char *done;
+	long ii, jj, start, end, cur, next;
+
+	if (num < 1 || nArrays < 1)return -1;
+	for (ii=0;ii<num;ii++) if (index[ii] < 0 || index[ii] >= num)return -1;
+
+	if (out != NULL)
+	{
+		for (start=0;start<num;start=end)
+		{
+			end=(start + PERMUTE_TILE < num) ? start + PERMUTE_TILE : num;
+			for (jj=0;jj<nArrays;jj++)
+			{
+				src=arrays[jj];
+				dst=out[jj];
+				for (ii=start;ii<end;ii++) dst[ii]=src[index[ii]];
+			}
+		}
+		return 0;
+	}
+
+	done=(unsigned char *)calloc(num,1);
+	hold=(double *)malloc(nArrays*sizeof(double));
+	if (done == NULL || hold == NULL)
+	{
+		free(done);
+		free(hold);
+		return -3;
+	}
+
+	/* each value must appear once, or the cycles would not close */
+	for (ii=0;ii<num;ii++)
+	{
+		if (done[index[ii]])
+		{
+			free(done);
+			free(hold);
+			return -2;
+		}
+		done[index[ii]]=1;
+	}
+	memset(done,0,num);
+
+	for (start=0;start<num;start++)
+	{
+		if (done[start] || index[start] == start)continue;
+
+		/* walk the cycle: each position takes the value from index[position] */
+		for (jj=0;jj<nArrays;jj++) hold[jj]=arrays[jj][start];
+		cur=start;
+		next=index[cur];
+		while (next != start)
+		{
+			for (jj=0;jj<nArrays;jj++) arrays[jj][cur]=arrays[jj][next];
+			done[cur]=1;
+			cur=next;
+			next=index[cur];
+		}
+		for (jj=0;jj<nArrays;jj++) arrays[jj][cur]=hold[jj];
+		done[cur]=1;
+	}
+
+	free(done);
+	free(hold);
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* Rolling percentile (rollPercentile...)													*/
+/*																							*/
+/* Keeps the last 'window' values in a ring and the values that are not NaN in two heaps:	*/
+/* a max heap with the lowest values, up to and including the wanted rank, and a min heap	*/
+/* with the rest.  The percentile is read from the two tops.  Each heap entry is a ring		*/
+/* slot and each slot knows its place in its heap, so the oldest value is removed			*/
+/* directly: adding a value costs O(log window).  NaNs take a place in the window but are	*/
+/* not used.																				*/
+/********************************************************************************************/
+struct rollPercentile
+{
+	long		window;
+	long		count;			/* values in the window */
+	long		head;			/* slot of the oldest value */
+	double		pct;
+	double		*vals;			/* ring of values */
+	long		*low;			/* max heap of slots, the numLow lowest values */
+	long		*high;			/* min heap of slots, the others */
+	long		*place;			/* heap position of each slot */
+	char		*side;			/* heap of each slot: 0 none (NaN), 1 low, 2 high */
+	long		numLow;
+	long		numHigh;
+};
+typedef struct rollPercentile rollPercentile;
+
+/* true if slot aa belongs above slot bb in the heap of 'side' */
+static int rpAbove (rollPercentile *rp, int side, long aa, long bb)
+{
+	if (side == 1)return rp->vals[aa] > rp->vals[bb];
+	return rp->vals[aa] < rp->vals[bb];
+}
+
+static void rpSet (rollPercentile *rp, long *heap, long ii, long slot)
+{
+	heap[ii]=slot;
+	rp->place[slot]=ii;
+}
+
+/* moves the slot at heap[ii] up or down to its place */
+static void rpSift (rollPercentile *rp, int side, long ii)
+{
+	long *heap, num, slot, child, parent;
+
+	heap=(side == 1) ? rp->low : rp->high;
+	num=(side == 1) ? rp->numLow : rp->numHigh;
+	slot=heap[ii];
+
+	while (ii > 0)
+	{
+		parent=(ii - 1)/2;
+		if (!rpAbove(rp,side,slot,heap[parent]))break;
+		rpSet(rp,heap,ii,heap[parent]);
+		ii=parent;
+	}
+
+	for (;;)
+	{
+		child=2*ii + 1;
+		if (child >= num)break;
+		if (child + 1 < num && rpAbove(rp,side,heap[child+1],heap[child])) child++;
+		if (!rpAbove(rp,side,heap[child],slot))break;
+		rpSet(rp,heap,ii,heap[child]);
+		ii=child;
+	}
+	rpSet(rp,heap,ii,slot);
+}
+
+static void rpPush (rollPercentile *rp, int side, long slot)
+{
+	rp->side[slot]=(char)side;
+	if (side == 1)
+	{
+		rpSet(rp,rp->low,rp->numLow++,slot);
+		rpSift(rp,1,rp->numLow-1);
+	}
+	else
+	{
+		rpSet(rp,rp->high,rp->numHigh++,slot);
+		rpSift(rp,2,rp->numHigh-1);
+	}
+}
+
+/* takes 'slot' out of its heap */
+static void rpRemove (rollPercentile *rp, long slot)
+{
+	long *heap, last, ii;
+	int side;
+
+	side=rp->side[slot];
+	if (side == 0)return;
+	rp->side[slot]=0;
+
+	heap=(side == 1) ? rp->low : rp->high;
+	last=(side == 1) ? --rp->numLow : --rp->numHigh;
+	ii=rp->place[slot];
+	if (ii == last)return;
+
+	rpSet(rp,heap,ii,heap[last]);
+	rpSift(rp,side,ii);
+}
+
+/* moves tops between the heaps until the low heap ends at the wanted rank */
+static void rpBalance (rollPercentile *rp)
+{
+	long valid, target, slot;
+
+	valid=rp->numLow + rp->numHigh;
+	if (valid == 0)return;
+
+	target=(long)(rp->pct/100.0*(valid - 1)) + 1;
+	while (rp->numLow > target)
+	{
+		slot=rp->low[0];
+		rpRemove(rp,slot);
+		rpPush(rp,2,slot);
+	}
+	while (rp->numLow < target)
+	{
+		slot=rp->high[0];
+		rpRemove(rp,slot);
+		rpPush(rp,1,slot);
+	}
+}
+
+static void rpDropOldest (rollPercentile *rp)
+{
+	rpRemove(rp,rp->head);
+	rp->head=(rp->head + 1)%rp->window;
+	rp->count--;
+	rpBalance(rp);
+}
+
+static void rpAdd (rollPercentile *rp, double value)
+{
+	long slot;
+
+	if (rp->count == rp->window) rpDropOldest(rp);
+
+	/* the heaps are balanced here, so the low heap is empty only if both are */
+	slot=(rp->head + rp->count)%rp->window;
+	rp->vals[slot]=value;
+	rp->count++;
+
+	if (value != value) rp->side[slot]=0;
+	else if (rp->numLow == 0 || value <= rp->vals[rp->low[0]]) rpPush(rp,1,slot);
+	else rpPush(rp,2,slot);
+
+	rpBalance(rp);
+}
+
+/* percentile of the window, returns -1 if it has no values that are not NaN */
+static long rpResult (rollPercentile *rp, double *result)
+{
+	double pos, frac, lower;
+	long valid;
+
+	valid=rp->numLow + rp->numHigh;
+	if (valid == 0)return -1;
+
+	pos=rp->pct/100.0*(valid - 1);
+	frac=pos - (long)pos;
+	lower=rp->vals[rp->low[0]];
+	*result=lower;
+	if (frac > 0.0 && rp->numHigh > 0) *result=lower + frac*(rp->vals[rp->high[0]] - lower);
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* rollPercentileCreate: This function creates a rolling percentile	*/
+/*	over the last 'window' values (window >= 1).  pct is 0 to 100,	*/
+/*	50 for a rolling median.										*/
+/*																	*/
+/* Function returns the rolling percentile, or NULL if window < 1,	*/
+/*	pct is not 0 to 100 or out of memory.  Release it with			*/
+/*	rollPercentileFree												*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	rollPercentile *rollPercentileCreate (long window, double pct)
+#else
+	DllExport rollPercentile * __cdecl rollPercentileCreate (long window, double pct)
+#endif
+{
+	rollPercentile *rp;
+
+	if (window < 1 || !(pct >= 0.0 && pct <= 100.0))return NULL;
+
+	rp=(rollPercentile *)malloc(sizeof(rollPercentile));
+	if (rp == NULL)return NULL;
+
+	rp->vals=(double *)malloc(window*sizeof(double));
+	rp->low=(long *)malloc(window*sizeof(long));
+	rp->high=(long *)malloc(window*sizeof(long));
+	rp->place=(long *)malloc(window*sizeof(long));
+	rp->side=(char *)malloc(window);
+	if (rp->vals == NULL || rp->low == NULL || rp->high == NULL || rp->place == NULL || rp->side == NULL)
+	{
+		free(rp->vals);
+		free(rp->low);
+		free(rp->high);
+		free(rp->place);
+		free(rp->side);
+		free(rp);
+		return NULL;
+	}
+
+	rp->window=window;
+	rp->pct=pct;
+	rp->count=0;
+	rp->head=0;
+	rp->numLow=0;
+	rp->numHigh=0;
+
+	return rp;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* rollPercentileFree: This function releases a rolling percentile	*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	void rollPercentileFree (rollPercentile *rp)
+#else
+	DllExport void __cdecl rollPercentileFree (rollPercentile *rp)
+#endif
+{
+	if (rp == NULL)return;
+
+	free(rp->vals);
+	free(rp->low);
+	free(rp->high);
+	free(rp->place);
+	free(rp->side);
+	free(rp);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* rollPercentileAdd: This function adds 'value', drops the oldest	*/
+/*	value if the window is full, and returns the percentile of the	*/
+/*	values now in the window, interpolated between the two closest	*/
+/*	ranks as percentiles does.  NaNs are ignored.					*/
+/*																	*/
+/* Function returns zero if no error, 1 if no error but the window	*/
+/*	is not full yet, -1 if the window has only NaNs (result is set	*/
+/*	to value)														*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long rollPercentileAdd (rollPercentile *rp, double value, double *result)
+#else
+	DllExport long __cdecl rollPercentileAdd (rollPercentile *rp, double value, double *result)
+#endif
+{
+	rpAdd(rp,value);
+
+	*result=value;
+	if (rpResult(rp,result) != 0)return -1;
+	if (rp->count < rp->window)return 1;
+
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* rollPercentile_array: This function filters 'data' with a rolling percentile (a rolling	*/
+/*  median for pct=50, e.g. to remove spikes).												*/
+/*																							*/
+/*  window: number of values in the window													*/
+/*  pct: percentile, 0 to 100																*/
+/*  how: 't' or 'T' for a trailing window, out[ii] is the percentile of						*/
+/*        data[ii-window+1] to data[ii];													*/
+/*       'c' or 'C' for a centered window, out[ii] is the percentile of						*/
+/*        data[ii-(window-1)/2] to data[ii+window/2].										*/
+/*       Near the ends of the data the window only holds the values that exist.				*/
+/*  out: returned num values.  NaNs are ignored; where a window has only NaNs, out[ii] is	*/
+/*   data[ii]																				*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1, window < 1, pct is not 0 to 100 or		*/
+/*  'how' is not valid, -3 if out of memory													*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long rollPercentile_array (double *data, long num, long window, double pct, char how, double *out)
+#else
+	DllExport long __cdecl rollPercentile_array (double *data, long num, long window, double pct, char how, double *out)
+#endif
+{
+	rollPercentile *rp;
+	long ii, back, ahead, first;
+
+	if (num < 1 || window < 1 || !(pct >= 0.0 && pct <= 100.0))return -1;
+	if (how == 'T' || how == 't')
+	{
+		back=window - 1;
+		ahead=0;
+	}
+	else if (how == 'C' || how == 'c')
+	{
+		back=(window - 1)/2;
+		ahead=window/2;
+	}
+	else return -1;
+
+	rp=rollPercentileCreate(window,pct);
+	if (rp == NULL)return -3;
+
+	for (ii=0;ii<ahead && ii<num;ii++) rpAdd(rp,data[ii]);
+
+	for (ii=0;ii<num;ii++)
+	{
+		if (ii + ahead < num) rpAdd(rp,data[ii+ahead]);
+		else
+		{
+			/* past the end: the window holds data[first] to data[num-1] */
+			first=(ii - back > 0) ? ii - back : 0;
+			while (rp->count > num - first) rpDropOldest(rp);
+		}
+
+		out[ii]=data[ii];
+		rpResult(rp,&out[ii]);
+	}
+
+	rollPercentileFree(rp);
+
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* histogram_array: This function counts the values of 'data' in numBins bins of equal		*/
+/*  width from lowEdge to highEdge.  The counts are added to 'counts', so one array can be	*/
+/*  fed with many data arrays, and histograms of the same bins (from other threads or		*/
+/*  files) are merged by adding their counts.  Counts are doubles so they do not overflow	*/
+/*  on very long records.  NaNs are not counted.											*/
+/*																							*/
+/*  counts: numBins+2 counts, set to zero before the first call:							*/
+/*   counts[0]=values below lowEdge															*/
+/*   counts[ii]=values from lowEdge+(ii-1)*width up to lowEdge+ii*width, ii=1..numBins		*/
+/*    (the last bin includes highEdge)														*/
+/*   counts[numBins+1]=values above highEdge												*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if numBins < 1 or highEdge <= lowEdge				*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long histogram_array (double *data, long num, double lowEdge, double highEdge, long numBins, double *counts)
+#else
+	DllExport long __cdecl histogram_array (double *data, long num, double lowEdge, double highEdge, long numBins, double *counts)
+#endif
+{
+	double scale, val;
+	long ii, bin;
+
+	if (numBins < 1 || !(highEdge > lowEdge))return -1;
+
+	scale=numBins/(highEdge - lowEdge);
+	for (ii=0;ii<num;ii++)
+	{
+		val=data[ii];
+		if (val < lowEdge) counts[0]+=1.0;
+		else if (val > highEdge) counts[numBins+1]+=1.0;
+		else if (val == val)
+		{
+			bin=(long)((val - lowEdge)*scale);
+			if (bin >= numBins) bin=numBins - 1;
+			counts[bin+1]+=1.0;
+		}
+	}
+
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* histogramPercentile: This function returns approximate percentiles from the counts of	*/
+/*  histogram_array (same lowEdge, highEdge and numBins), interpolating linearly within		*/
+/*  the bin that holds each percentile.  The error is at most one bin width.				*/
+/*																							*/
+/*  pct: np percentiles, 0 to 100															*/
+/*  out: returned np values.  A percentile that falls in the values below lowEdge or above	*/
+/*   highEdge is returned as lowEdge or highEdge											*/
+/*																							*/
+/*  Function returns 0 if no error, 1 if no error but one or more percentiles were set to	*/
+/*  lowEdge or highEdge, -1 if numBins < 1, np < 1 or highEdge <= lowEdge, -2 if a			*/
+/*  percentile is not 0 to 100 or there are no counts										*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long histogramPercentile (double *counts, long numBins, double lowEdge, double highEdge, double *pct, long np, double *out)
+#else
+	DllExport long __cdecl histogramPercentile (double *counts, long numBins, double lowEdge, double highEdge, double *pct, long np, double *out)
+#endif
+{
+	double total, target, cum, width;
+	long ii, jj, result;
+
+	for (ii=0;ii<np;ii++) out[ii]=0.0;
+	if (numBins < 1 || np < 1 || !(highEdge > lowEdge))return -1;
+	for (ii=0;ii<np;ii++) if (!(pct[ii] >= 0.0 && pct[ii] <= 100.0))return -2;
+
+	total=0.0;
+	for (jj=0;jj<numBins+2;jj++) total+=counts[jj];
+	if (total <= 0.0)return -2;
+
+	width=(highEdge - lowEdge)/numBins;
+	result=0;
+	for (ii=0;ii<np;ii++)
+	{
+		target=pct[ii]/100.0*total;
+		if (target < counts[0] || (counts[0] > 0.0 && target == 0.0))
+		{
+			out[ii]=lowEdge;
+			result=1;
+			continue;
+		}
+
+		cum=counts[0];
+		for (jj=1;jj<=numBins;jj++)
+		{
+			if (counts[jj] > 0.0 && target <= cum + counts[jj])break;
+			cum+=counts[jj];
+		}
+
+		if (jj > numBins)
+		{
+			out[ii]=highEdge;
+			result=1;
+		}
+		else out[ii]=lowEdge + (jj - 1 + (target - cum)/counts[jj])*width;
+	}
+
+	return result;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* Quantile sketch (quantSketch...)															*/
+/*																							*/
+/* A KLL sketch: approximate quantiles of any number of values in a few thousand doubles.	*/
+/* Values go into level 0; when a level is full it is sorted and every other value			*/
+/* (starting at random at the first or second) moves up one level, where each value stands	*/
+/* for twice as many.  Level capacities shrink by 2/3 going down from the top level of k		*/
+/* values.  The rank error is about 1.7/k of the count (k=200: under 1%), independent of	*/
+/* the count.  Sketches with the same k are merged by joining their levels and				*/
+/* compacting, so they can be built per thread or per file.  The random bits come from a	*/
+/* fixed seed, so results are repeatable.													*/
+/********************************************************************************************/
+#define KLL_DEFAULT_K	200
+#define KLL_MIN_K		8
+#define KLL_MAX_K		65535
+#define KLL_MAX_LEVELS	60
+#define KLL_MAGIC		0x314C4C4B	/* "KLL1" */
+
+struct quantSketch
+{
+	long		k;
+	long		numLevels;
+	tdsInt64	count;
+	double		minVal;
+	double		maxVal;
+	unsigned int rng;
+	double		*items[KLL_MAX_LEVELS];
+	long		size[KLL_MAX_LEVELS];
+	long		alloc[KLL_MAX_LEVELS];
+};
+typedef struct quantSketch quantSketch;
+
+/* capacity of level 'lev' */
+static long kllCapacity (quantSketch *sk, long lev)
+{
+	double cap;
+	long ii;
+
+	cap=(double)sk->k;
+	for (ii=lev;ii<sk->numLevels-1 && cap>2.0;ii++) cap*=2.0/3.0;
+
+	return (cap > 2.0) ? (long)ceil(cap) : 2;
+}
+
+/* makes room for 'need' values in level 'lev' */
+static long kllReserve (quantSketch *sk, long lev, long need)
+{
+	double *items;
+	long alloc;
+
+	if (need <= sk->alloc[lev])return 0;
+
+	alloc=sk->alloc[lev] ? sk->alloc[lev] : 16;
+	while (alloc < need) alloc*=2;
+	items=(double *)realloc(sk->items[lev],alloc*sizeof(double));
+	if (items == NULL)return -3;
+
+	sk->items[lev]=items;
+	sk->alloc[lev]=alloc;
+	return 0;
+}
+
+/* moves data[jj] down to its place in the max heap data[0..end-1] */
+static void kllSift (double *data, long jj, long end)
+{
+	double val;
+	long child;
+
+	val=data[jj];
+	for (;;)
+	{
+		child=2*jj + 1;
+		if (child >= end)break;
+		if (child + 1 < end && data[child+1] > data[child]) child++;
+		if (!(data[child] > val))break;
+		data[jj]=data[child];
+		jj=child;
+	}
+	data[jj]=val;
+}
+
+/* heap sort, no work space */
+static void kllSort (double *data, long num)
+{
+	double val;
+	long ii;
+
+	for (ii=num/2-1;ii>=0;ii--) kllSift(data,ii,num);
+	for (ii=num-1;ii>0;ii--)
+	{
+		val=data[0];
+		data[0]=data[ii];
+		data[ii]=val;
+		kllSift(data,0,ii);
+	}
+}
+
+/* compacts levels until the sketch is within capacity */
+static long kllCompact (quantSketch *sk)
+{
+	double *src, *dst;
+	long lev, total, capTotal, half, odd, offset, ii;
+
+	for (;;)
+	{
+		total=0;
+		capTotal=0;
+		for (lev=0;lev<sk->numLevels;lev++)
+		{
+			total+=sk->size[lev];
+			capTotal+=kllCapacity(sk,lev);
+		}
+		if (total <= capTotal)return 0;
+
+		for (lev=0;lev<sk->numLevels-1;lev++) if (sk->size[lev] >= kllCapacity(sk,lev))break;
+		if (lev == sk->numLevels-1)
+		{
+			if (sk->numLevels == KLL_MAX_LEVELS)return -3;
+			sk->size[sk->numLevels++]=0;
+		}
+
+		half=sk->size[lev]/2;
+		odd=sk->size[lev] & 1;
+		if (kllReserve(sk,lev+1,sk->size[lev+1] + half) != 0)return -3;
+
+		sk->rng^=sk->rng << 13;
+		sk->rng^=sk->rng >> 17;
+		sk->rng^=sk->rng << 5;
+		offset=(long)(sk->rng & 1);
+
+		/* the lowest value stays if the count is odd */
+		src=sk->items[lev];
+		kllSort(src,sk->size[lev]);
+		dst=sk->items[lev+1] + sk->size[lev+1];
+		for (ii=0;ii<half;ii++) dst[ii]=src[odd + 2*ii + offset];
+		sk->size[lev+1]+=half;
+		sk->size[lev]=odd;
+	}
+}
+
+/********************************************************************/
+/*                                                                  */
+/* quantSketchCreate: This function creates an empty quantile		*/
+/*	sketch.  k (8 to 65535) sets the accuracy and size: the rank	*/
+/*	error is about 1.7/k of the count and the sketch holds about	*/
+/*	3k values.  k=0 uses the default of 200.						*/
+/*																	*/
+/* Function returns the sketch, or NULL if k is not valid or out	*/
+/*	of memory.  Release it with quantSketchFree						*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	quantSketch *quantSketchCreate (long k)
+#else
+	DllExport quantSketch * __cdecl quantSketchCreate (long k)
+#endif
+{
+	quantSketch *sk;
+
+	if (k == 0) k=KLL_DEFAULT_K;
+	if (k < KLL_MIN_K || k > KLL_MAX_K)return NULL;
+
+	sk=(quantSketch *)calloc(1,sizeof(quantSketch));
+	if (sk == NULL)return NULL;
+
+	sk->k=k;
+	sk->numLevels=1;
+	sk->rng=0x9E3779B9;
+	sk->minVal=0.0;
+	sk->maxVal=0.0;
+	if (kllReserve(sk,0,k) != 0)
+	{
+		free(sk);
+		return NULL;
+	}
+
+	return sk;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* quantSketchFree: This function releases a quantile sketch		*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	void quantSketchFree (quantSketch *sk)
+#else
+	DllExport void __cdecl quantSketchFree (quantSketch *sk)
+#endif
+{
+	long lev;
+
+	if (sk == NULL)return;
+
+	for (lev=0;lev<KLL_MAX_LEVELS;lev++) free(sk->items[lev]);
+	free(sk);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* quantSketchAdd_array: This function adds 'num' values to the		*/
+/*	sketch.  NaNs are not added.									*/
+/*																	*/
+/* Function returns zero if no error, -1 if sk is NULL, -3 out of	*/
+/*	memory															*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long quantSketchAdd_array (quantSketch *sk, double *data, long num)
+#else
+	DllExport long __cdecl quantSketchAdd_array (quantSketch *sk, double *data, long num)
+#endif
+{
+	double *level0, val;
+	long ii, cap0, used;
+
+	if (sk == NULL)return -1;
+
+	cap0=kllCapacity(sk,0);
+	for (ii=0;ii<num;ii++)
+	{
+		val=data[ii];
+		if (val != val)continue;
+
+		if (sk->count == 0)
+		{
+			sk->minVal=val;
+			sk->maxVal=val;
+		}
+		else if (val < sk->minVal) sk->minVal=val;
+		else if (val > sk->maxVal) sk->maxVal=val;
+		sk->count++;
+
+		used=sk->size[0];
+		if (used >= cap0)
+		{
+			if (kllCompact(sk) != 0)return -3;
+			cap0=kllCapacity(sk,0);
+			used=sk->size[0];
+		}
+		if (used >= sk->alloc[0] && kllReserve(sk,0,used + 1) != 0)return -3;
+
+		level0=sk->items[0];
+		level0[used]=val;
+		sk->size[0]=used + 1;
+	}
+
+	return kllCompact(sk);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* quantSketchMerge: This function adds the values of sketch 'src'	*/
+/*	to sketch 'dest' (both made with the same k).  src is not		*/
+/*	changed.														*/
+/*																	*/
+/* Function returns zero if no error, -1 if a sketch is NULL or		*/
+/*	the k values differ, -3 out of memory							*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long quantSketchMerge (quantSketch *dest, quantSketch *src)
+#else
+	DllExport long __cdecl quantSketchMerge (quantSketch *dest, quantSketch *src)
+#endif
+{
+	long lev;
+
+	if (dest == NULL || src == NULL || dest->k != src->k || dest == src)return -1;
+	if (src->count == 0)return 0;
+
+	while (dest->numLevels < src->numLevels) dest->size[dest->numLevels++]=0;
+	for (lev=0;lev<src->numLevels;lev++)
+	{
+		if (kllReserve(dest,lev,dest->size[lev] + src->size[lev]) != 0)return -3;
+		memcpy(dest->items[lev] + dest->size[lev],src->items[lev],src->size[lev]*sizeof(double));
+		dest->size[lev]+=src->size[lev];
+	}
+
+	if (dest->count == 0 || src->minVal < dest->minVal) dest->minVal=src->minVal;
+	if (dest->count == 0 || src->maxVal > dest->maxVal) dest->maxVal=src->maxVal;
+	dest->count+=src->count;
+
+	return kllCompact(dest);
+}
+
+/********************************************************************************************/
+/*																							*/
+/* quantSketchQuantile: This function returns approximate percentiles of the values added	*/
+/*  to the sketch.  0 and 100 return the exact minimum and maximum.							*/
+/*																							*/
+/*  pct: np percentiles, 0 to 100															*/
+/*  out: returned np values																	*/
+/*  count: returned number of values added (may be NULL)									*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if sk is NULL or np < 1, -2 if a percentile is not	*/
+/*  0 to 100 or the sketch is empty, -3 if out of memory									*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long quantSketchQuantile (quantSketch *sk, double *pct, long np, double *out, double *count)
+#else
+	DllExport long __cdecl quantSketchQuantile (quantSketch *sk, double *pct, long np, double *out, double *count)
+#endif
+{
+	double *vals, *cum, *arrays[2], target, weight;
+	long *index, ii, lev, num, lo, hi, mid;
+
+	for (ii=0;ii<np;ii++) out[ii]=0.0;
+	if (count != NULL) *count=0.0;
+	if (sk == NULL || np < 1)return -1;
+	if (count != NULL) *count=(double)sk->count;
+	for (ii=0;ii<np;ii++) if (!(pct[ii] >= 0.0 && pct[ii] <= 100.0))return -2;
+	if (sk->count == 0)return -2;
+
+	num=0;
+	for (lev=0;lev<sk->numLevels;lev++) num+=sk->size[lev];
+
+	vals=(double *)malloc(num*sizeof(double));
+	cum=(double *)malloc(num*sizeof(double));
+	index=(long *)malloc(num*sizeof(long));
+	if (vals == NULL || cum == NULL || index == NULL)
+	{
+		free(vals);
+		free(cum);
+		free(index);
+		return -3;
+	}
+
+	/* every value with the weight of its level, sorted by value */
+	num=0;
+	weight=1.0;
+	for (lev=0;lev<sk->numLevels;lev++)
+	{
+		for (ii=0;ii<sk->size[lev];ii++)
+		{
+			vals[num]=sk->items[lev][ii];
+			cum[num++]=weight;
+		}
+		weight*=2.0;
+	}
+
+	arrays[0]=vals;
+	arrays[1]=cum;
+	if (sortDoubleAdaptive(vals,num,'a',index) != 0 || permuteArrays(index,num,arrays,2,NULL) != 0)
+	{
+		free(vals);
+		free(cum);
+		free(index);
+		return -3;
+	}
+	for (ii=1;ii<num;ii++) cum[ii]+=cum[ii-1];
+
+	for (ii=0;ii<np;ii++)
+	{
+		if (pct[ii] == 0.0) out[ii]=sk->minVal;
+		else if (pct[ii] == 100.0) out[ii]=sk->maxVal;
+		else
+		{
+			/* first value whose cumulative weight passes the rank */
+			target=pct[ii]/100.0*(double)(sk->count - 1);
+			lo=0;
+			hi=num - 1;
+			while (lo < hi)
+			{
+				mid=lo + (hi - lo)/2;
+				if (cum[mid] > target) hi=mid;
+				else lo=mid + 1;
+			}
+			out[ii]=vals[lo];
+		}
+	}
+
+	free(vals);
+	free(cum);
+	free(index);
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* quantSketchSerialize: This function writes the sketch to 'buffer', to be stored or sent	*/
+/*  and read back with quantSketchDeserialize on a machine with the same byte order.		*/
+/*  The layout is: 4 byte magic "KLL1", k, number of levels and random state (4 bytes		*/
+/*  each), count (8 bytes), minimum and maximum (doubles), the number of values in each		*/
+/*  level (4 bytes each), then the values of each level (doubles).							*/
+/*																							*/
+/*  bufSize: size of buffer in bytes														*/
+/*  size: returned number of bytes needed (and written if no error)							*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if sk is NULL, -2 if buffer is NULL or smaller than	*/
+/*  size (call with buffer NULL to get the size)											*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long quantSketchSerialize (quantSketch *sk, char *buffer, long bufSize, long *size)
+#else
+	DllExport long __cdecl quantSketchSerialize (quantSketch *sk, char *buffer, long bufSize, long *size)
+#endif
+{
+	char *pos;
+	int ival;
+	long lev, need;
+
+	*size=0;
+	if (sk == NULL)return -1;
+
+	need=4*sizeof(int) + sizeof(tdsInt64) + 2*sizeof(double) + sk->numLevels*sizeof(int);
+	for (lev=0;lev<sk->numLevels;lev++) need+=sk->size[lev]*sizeof(double);
+	*size=need;
+	if (buffer == NULL || bufSize < need)return -2;
+
+	pos=buffer;
+	ival=KLL_MAGIC;
+	memcpy(pos,&ival,sizeof(int));
+	pos+=sizeof(int);
+	ival=(int)sk->k;
+	memcpy(pos,&ival,sizeof(int));
+	pos+=sizeof(int);
+	ival=(int)sk->numLevels;
+	memcpy(pos,&ival,sizeof(int));
+	pos+=sizeof(int);
+	memcpy(pos,&sk->rng,sizeof(int));
+	pos+=sizeof(int);
+	memcpy(pos,&sk->count,sizeof(tdsInt64));
+	pos+=sizeof(tdsInt64);
+	memcpy(pos,&sk->minVal,sizeof(double));
+	pos+=sizeof(double);
+	memcpy(pos,&sk->maxVal,sizeof(double));
+	pos+=sizeof(double);
+
+	for (lev=0;lev<sk->numLevels;lev++)
+	{
+		ival=(int)sk->size[lev];
+		memcpy(pos,&ival,sizeof(int));
+		pos+=sizeof(int);
+	}
+	for (lev=0;lev<sk->numLevels;lev++)
+	{
+		memcpy(pos,sk->items[lev],sk->size[lev]*sizeof(double));
+		pos+=sk->size[lev]*sizeof(double);
+	}
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* quantSketchDeserialize: This function creates a sketch from the	*/
+/*	'size' bytes written by quantSketchSerialize					*/
+/*																	*/
+/* Function returns the sketch, or NULL if the buffer is not a		*/
+/*	valid sketch or out of memory.  Release it with quantSketchFree	*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	quantSketch *quantSketchDeserialize (char *buffer, long size)
+#else
+	DllExport quantSketch * __cdecl quantSketchDeserialize (char *buffer, long size)
+#endif
+{
+	quantSketch *sk;
+	char *pos;
+	int ival, kk, numLevels;
+	long lev, need, total;
+
+	need=4*sizeof(int) + sizeof(tdsInt64) + 2*sizeof(double);
+	if (buffer == NULL || size < need)return NULL;
+
+	memcpy(&ival,buffer,sizeof(int));
+	memcpy(&kk,buffer+sizeof(int),sizeof(int));
+	memcpy(&numLevels,buffer+2*sizeof(int),sizeof(int));
+	if (ival != KLL_MAGIC || kk < KLL_MIN_K || kk > KLL_MAX_K)return NULL;
+	if (numLevels < 1 || numLevels > KLL_MAX_LEVELS)return NULL;
+	if (size < need + numLevels*(long)sizeof(int))return NULL;
+
+	sk=quantSketchCreate(kk);
+	if (sk == NULL)return NULL;
+
+	pos=buffer + 3*sizeof(int);
+	memcpy(&sk->rng,pos,sizeof(int));
+	pos+=sizeof(int);
+	memcpy(&sk->count,pos,sizeof(tdsInt64));
+	pos+=sizeof(tdsInt64);
+	memcpy(&sk->minVal,pos,sizeof(double));
+	pos+=sizeof(double);
+	memcpy(&sk->maxVal,pos,sizeof(double));
+	pos+=sizeof(double);
+
+	sk->numLevels=numLevels;
+	total=0;
+	for (lev=0;lev<numLevels;lev++)
+	{
+		memcpy(&ival,pos,sizeof(int));
+		pos+=sizeof(int);
+		sk->size[lev]=ival;
+		if (ival < 0 || total + ival > size)
+		{
+			quantSketchFree(sk);
+			return NULL;
+		}
+		total+=ival;
+	}
+
+	need+=numLevels*sizeof(int) + total*sizeof(double);
+	if (size != need || sk->count < total || sk->rng == 0)
+	{
+		quantSketchFree(sk);
+		return NULL;
+	}
+
+	for (lev=0;lev<numLevels;lev++)
+	{
+		if (kllReserve(sk,lev,sk->size[lev]) != 0)
+		{
+			quantSketchFree(sk);
+			return NULL;
+		}
+		memcpy(sk->items[lev],pos,sk->size[lev]*sizeof(double));
+		pos+=sk->size[lev]*sizeof(double);
+	}
+
+	return sk;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* Theil-Sen robust linear fit (theilSenSlope...)					*/
+/*																	*/
+/* The slope is the median of the slopes of all pairs of points		*/
+/* with different x, found without listing the n^2/2 pairs.  With	*/
+/* the points in x order, the number of pair slopes below s is the	*/
+/* number of inversions of y - s*x, counted by a merge sort in		*/
+/* O(n log n).  The pair slopes inside a range [lo,hi) are the		*/
+/* inversions of y - hi*x with the points in y - lo*x order, so the	*/
+/* same merge sort can list them, or a random sample of them.		*/
+/* Each round samples about n slopes of the range holding the		*/
+/* median and narrows it around the sample quantiles, until the		*/
+/* range holds few enough slopes to list them all and select the	*/
+/* median.  Bisection of the range is the fallback if sampling		*/
+/* stops helping.  The random generator has a fixed seed, so		*/
+/* results are repeatable.											*/
+/********************************************************************/
+#define TS_SAMPLE_ROUNDS	8
+#define TS_MAX_BISECT		80
+
+typedef struct
+{
+	long	num;
+	double	*xc;		/* x - x0 */
+	double	*yc;		/* y - y0 */
+	long	*xord;		/* point order by x, then y */
+	long	*uord;		/* point order for listing, tsListPairs */
+	long	*work;
+	long	*ids;
+	long	*tmpIds;
+	double	*vals;
+	double	*tmpVals;
+	double	*pairs;		/* listed or sampled slopes */
+	long	maxPairs;
+	long	numListed;
+	double	nextPair;	/* index of the next inversion to list */
+	double	pairRate;	/* fraction of the inversions listed */
+	double	numPairs;	/* pairs with different x */
+	unsigned long	seed;
+} theilSenWork;
+
+static void tsFree (theilSenWork *ts)
+{
+	free(ts->xc);
+	free(ts->yc);
+	free(ts->xord);
+	free(ts->uord);
+	free(ts->work);
+	free(ts->ids);
+	free(ts->tmpIds);
+	free(ts->vals);
+	free(ts->tmpVals);
+	free(ts->pairs);
+}
+
+static long tsAlloc (theilSenWork *ts, long num)
+{
+	ts->num=num;
+	ts->maxPairs=4*num + 1024;
+	ts->xc=(double *)malloc(num*sizeof(double));
+	ts->yc=(double *)malloc(num*sizeof(double));
+	ts->xord=(long *)malloc(num*sizeof(long));
+	ts->uord=(long *)malloc(num*sizeof(long));
+	ts->work=(long *)malloc(num*sizeof(long));
+	ts->ids=(long *)malloc(num*sizeof(long));
+	ts->tmpIds=(long *)malloc(num*sizeof(long));
+	ts->vals=(double *)malloc(num*sizeof(double));
+	ts->tmpVals=(double *)malloc(num*sizeof(double));
+	ts->pairs=(double *)malloc(ts->maxPairs*sizeof(double));
+	if (ts->xc == NULL || ts->yc == NULL || ts->xord == NULL || ts->uord == NULL || ts->work == NULL ||
+		ts->ids == NULL || ts->tmpIds == NULL || ts->vals == NULL || ts->tmpVals == NULL || ts->pairs == NULL)
+	{
+		tsFree(ts);
+		return -3;
+	}
+	return 0;
+}
+
+/* number of inversions to skip before the next listed one: geometric	*/
+/* with ts->pairRate, from a xorshift random number						*/
+static double tsSkip (theilSenWork *ts)
+{
+	unsigned long xx;
+
+	if (ts->pairRate >= 1.0)return 0.0;
+
+	xx=ts->seed;
+	xx^=(xx << 13) & 0xffffffffUL;
+	xx^=xx >> 17;
+	xx^=(xx << 5) & 0xffffffffUL;
+	ts->seed=xx;
+
+	return floor(log(((double)xx + 1.0)/4294967296.0)/log(1.0 - ts->pairRate));
+}
+
+/* counts the inversions (later value < earlier value) of vals[] by	*/
+/* merge sort.  If 'list' is set the slopes of the inverted pairs of	*/
+/* points ids[] are listed in ts->pairs at rate ts->pairRate.  vals	*/
+/* and ids are sorted												*/
+static double tsInversions (theilSenWork *ts, long list)
+{
+	long width, left, mid, right, aa, bb, kk, tt, num;
+	double *srcV, *dstV, *tmpV;
+	long *srcI, *dstI, *tmpI;
+	double count;
+
+	num=ts->num;
+	count=0.0;
+	srcV=ts->vals;
+	dstV=ts->tmpVals;
+	srcI=ts->ids;
+	dstI=ts->tmpIds;
+	for (width=1;width<num;width*=2)
+	{
+		for (left=0;left<num;left+=2*width)
+		{
+			mid=(left + width < num) ? left + width : num;
+			right=(left + 2*width < num) ? left + 2*width : num;
+			aa=left;
+			bb=mid;
+			kk=left;
+			while (aa < mid && bb < right)
+			{
+				if (srcV[bb] < srcV[aa])
+				{
+					/* srcI[bb] makes an inversion with each of srcI[aa..mid-1] */
+					count=count + (double)(mid - aa);
+					while (list && ts->nextPair < count && ts->numListed < ts->maxPairs)
+					{
+						tt=mid - (long)(count - ts->nextPair);
+						ts->pairs[ts->numListed++]=(ts->yc[srcI[bb]] - ts->yc[srcI[tt]])/(ts->xc[srcI[bb]] - ts->xc[srcI[tt]]);
+						ts->nextPair=ts->nextPair + 1.0 + tsSkip(ts);
+					}
+					dstI[kk]=srcI[bb];
+					dstV[kk++]=srcV[bb++];
+				}
+				else
+				{
+					dstI[kk]=srcI[aa];
+					dstV[kk++]=srcV[aa++];
+				}
+			}
+			while (aa < mid)
+			{
+				dstI[kk]=srcI[aa];
+				dstV[kk++]=srcV[aa++];
+			}
+			while (bb < right)
+			{
+				dstI[kk]=srcI[bb];
+				dstV[kk++]=srcV[bb++];
+			}
+		}
+		tmpV=srcV; srcV=dstV; dstV=tmpV;
+		tmpI=srcI; srcI=dstI; dstI=tmpI;
+	}
+
+	return count;
+}
+
+/* number of pair slopes < ss */
+static double tsCountBelow (theilSenWork *ts, double ss)
+{
+	long ii, pp;
+
+	if (ss == -HUGE_VAL)return 0.0;
+	if (ss == HUGE_VAL)return ts->numPairs;
+
+	for (ii=0;ii<ts->num;ii++)
+	{
+		pp=ts->xord[ii];
+		ts->vals[ii]=ts->yc[pp] - ss*ts->xc[pp];
+		ts->ids[ii]=pp;
+	}
+
+	return tsInversions(ts,0);
+}
+
+/* lists the pair slopes in [lo,hi) into ts->pairs, each with			*/
+/* probability 'rate'.  With the points ordered by y - lo*x (ties by x),	*/
+/* those pairs are the inversions of y - hi*x.  Returns the number		*/
+/* listed																*/
+static long tsListPairs (theilSenWork *ts, double lo, double hi, double rate)
+{
+	long ii, pp;
+
+	if (lo == -HUGE_VAL)
+	{
+		memcpy(ts->uord,ts->xord,ts->num*sizeof(long));
+	}
+	else
+	{
+		for (ii=0;ii<ts->num;ii++)ts->vals[ii]=ts->yc[ii] - lo*ts->xc[ii];
+		tdsMergeArgsort(ts->vals,ts->xc,ts->num,ts->uord,ts->work);
+	}
+
+	for (ii=0;ii<ts->num;ii++)
+	{
+		pp=ts->uord[ii];
+		ts->vals[ii]=(hi == HUGE_VAL) ? -ts->xc[pp] : ts->yc[pp] - hi*ts->xc[pp];
+		ts->ids[ii]=pp;
+	}
+
+	ts->pairRate=rate;
+	ts->numListed=0;
+	ts->nextPair=tsSkip(ts);
+	tsInversions(ts,1);
+
+	return ts->numListed;
+}
+
+/* maps a double to an integer with the same order, for bisection */
+static tdsInt64 tsOrderedBits (double val)
+{
+	tdsInt64 bits;
+
+	memcpy(&bits,&val,sizeof(bits));
+	if (bits < 0) bits=-(bits & ~((tdsInt64)1 << 63));
+	return bits;
+}
+
+static double tsFromOrderedBits (tdsInt64 bits)
+{
+	double val;
+
+	if (bits < 0) bits=(-bits) | ((tdsInt64)1 << 63);
+	memcpy(&val,&bits,sizeof(val));
+	return val;
+}
+
+/* the rank-th smallest pair slope (0 based) */
+static double tsSelectRank (theilSenWork *ts, double rank)
+{
+	double lo, hi, cLo, cHi, cand[2], cc, frac, pos, spread, rate;
+	tdsInt64 bLo, bHi;
+	long round, bisect, mm, kk;
+
+	lo=-HUGE_VAL;
+	hi=HUGE_VAL;
+	cLo=0.0;
+	cHi=ts->numPairs;
+
+	round=0;
+	bisect=0;
+	while (1)
+	{
+		if (cHi - cLo <= (double)ts->maxPairs)
+		{
+			mm=tsListPairs(ts,lo,hi,1.0);
+			kk=(long)(rank - cLo);
+			if (kk >= mm) kk=mm - 1;
+			if (kk < 0)return lo;
+			return tdsSelect(ts->pairs,mm,kk);
+		}
+
+		bLo=tsOrderedBits(lo);
+		bHi=tsOrderedBits(hi);
+		if (bLo >= bHi - 1 || bisect >= TS_MAX_BISECT)return lo;
+
+		mm=0;
+		if (round < TS_SAMPLE_ROUNDS)
+		{
+			/* random sample of about num slopes in [lo,hi) */
+			round++;
+			rate=(double)ts->num/(cHi - cLo);
+			mm=tsListPairs(ts,lo,hi,rate);
+		}
+
+		if (mm >= 16)
+		{
+			frac=(rank - cLo + 0.5)/(cHi - cLo);
+			spread=3.0*sqrt((double)mm);
+			pos=frac*mm - spread;
+			kk=(pos < 0.0) ? 0 : (long)pos;
+			cand[0]=tdsSelect(ts->pairs,mm,kk);
+			pos=frac*mm + spread;
+			kk=(pos > mm - 1) ? mm - 1 : (long)pos;
+			cand[1]=tdsSelect(ts->pairs,mm,kk);
+
+			/* many equal slopes: try just above them */
+			if (cand[1] == cand[0]) cand[1]=tsFromOrderedBits(tsOrderedBits(cand[0]) + 1);
+		}
+		else
+		{
+			/* bisection of the range */
+			bisect++;
+			cand[0]=tsFromOrderedBits((bLo >> 1) + (bHi >> 1) + (bLo & bHi & 1));
+			cand[1]=cand[0];
+		}
+
+		for (kk=0;kk<2;kk++)
+		{
+			if (kk == 1 && cand[1] == cand[0])break;
+			if (cand[kk] <= lo || cand[kk] >= hi)continue;
+			cc=tsCountBelow(ts,cand[kk]);
+			if (cc <= rank)
+			{
+				lo=cand[kk];
+				cLo=cc;
+			}
+			else
+			{
+				hi=cand[kk];
+				cHi=cc;
+			}
+		}
+	}
+}
+
+/* slope and intercept of one channel, ts->xc filled.  x0, y0 are the	*/
+/* origin of xc and yc													*/
+static long tsFit (theilSenWork *ts, double *ydata, double x0, double *slope, double *intercept)
+{
+	long ii, gg, num;
+	double y0, ss, ties, rank;
+
+	num=ts->num;
+	for (ii=0;ii<num;ii++)
+	{
+		if (ydata[ii] - ydata[ii] != 0.0)return -2;
+	}
+
+	y0=ydata[num/2];
+	for (ii=0;ii<num;ii++)ts->yc[ii]=ydata[ii] - y0;
+	tdsMergeArgsort(ts->xc,ts->yc,num,ts->xord,ts->work);
+
+	/* pairs with equal x have no slope */
+	ties=0.0;
+	for (ii=0;ii<num;ii=gg)
+	{
+		for (gg=ii+1;gg<num && ts->xc[ts->xord[gg]] == ts->xc[ts->xord[ii]];gg++);
+		ties=ties + 0.5*(double)(gg - ii)*(double)(gg - ii - 1);
+	}
+	ts->numPairs=0.5*(double)num*(double)(num - 1) - ties;
+	if (ts->numPairs < 1.0)return -1;
+
+	ts->seed=0x9e3779b9UL;
+
+	rank=floor((ts->numPairs - 1.0)/2.0);
+	ss=tsSelectRank(ts,rank);
+	if (fmod(ts->numPairs,2.0) == 0.0) ss=0.5*(ss + tsSelectRank(ts,rank + 1.0));
+
+	for (ii=0;ii<num;ii++)ts->vals[ii]=ts->yc[ii] - ss*ts->xc[ii];
+
+	*slope=ss;
+	*intercept=tdsMedian(ts->vals,num) + y0 - ss*x0;
+
+	return 0;
+}
+
+/* centers xdata, returns -2 if not finite */
+static long tsSetX (theilSenWork *ts, double *xdata, double *x0)
+{
+	long ii;
+
+	for (ii=0;ii<ts->num;ii++)
+	{
+		if (xdata[ii] - xdata[ii] != 0.0)return -2;
+	}
+	*x0=xdata[ts->num/2];
+	for (ii=0;ii<ts->num;ii++)ts->xc[ii]=xdata[ii] - *x0;
+
+	return 0;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* theilSenSlope: This function performs a robust (Theil-Sen)		*/
+/*	linear fit: the slope is the median of the slopes between all	*/
+/*	pairs of points with different x, and the intercept is the		*/
+/*	median of y - slope*x.  Up to 29% of the points can be outliers	*/
+/*	without changing the result much.  Computing time is			*/
+/*	O(num log num).													*/
+/*																	*/
+/* Calling parameters:												*/
+/*   xdata=vector containing independent variable data				*/
+/*   ydata=vector containing dependent variable data				*/
+/*   num=number of data points in xdata (and in ydata)				*/
+/*																	*/
+/* Returned parameters:												*/
+/*   slope=slope of Y=aX + B (slope=a)								*/
+/*   intercept=intercept of Y=aX + B (intercept=B)					*/
+/*																	*/
+/* Function returns zero if no error, -1 if num < 2 or all x are	*/
+/*	equal, -2 if the data is not finite (NaN or infinity),			*/
+/*	-3 if out of memory												*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long theilSenSlope (double *xdata, double *ydata, long num, double *slope, double *intercept)
+#else
+	DllExport long __cdecl theilSenSlope (double *xdata, double *ydata, long num, double *slope, double *intercept)
+#endif
+{
+	theilSenWork ts;
+	double x0;
+	long result;
+
+	*slope=0.0;
+	*intercept=0.0;
+
+	if (num < 2)return -1;
+	if (tsAlloc(&ts,num) != 0)return -3;
+
+	result=tsSetX(&ts,xdata,&x0);
+	if (result == 0) result=tsFit(&ts,ydata,x0,slope,intercept);
+
+	tsFree(&ts);
+
+	return result;
+}
+
+/********************************************************************/
+/*                                                                  */
+/* theilSenSlope_multi: This function performs theilSenSlope for	*/
+/*	'numY' channels sharing the same xdata.							*/
+/*																	*/
+/* Calling parameters:												*/
+/*   xdata=vector containing independent variable data				*/
+/*   ydata=num x numY values, column major (channel k is			*/
+/*		ydata[k*num] to ydata[k*num+num-1])							*/
+/*   num=number of data points in xdata and each channel			*/
+/*   numY=number of channels										*/
+/*																	*/
+/* Returned parameters (numY values each):							*/
+/*   slope, intercept as returned by theilSenSlope					*/
+/*																	*/
+/* Function returns zero if no error, -1 if num < 2 or numY < 1,	*/
+/*	-2 if theilSenSlope would fail for one or more channels,		*/
+/*	-3 if out of memory												*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	long theilSenSlope_multi (double *xdata, double *ydata, long num, long numY, double *slope, double *intercept)
+#else
+	DllExport long __cdecl theilSenSlope_multi (double *xdata, double *ydata, long num, long numY, double *slope, double *intercept)
+#endif
+{
+	theilSenWork ts;
+	double x0;
+	long ch, result;
+
+	for (ch=0;ch<numY;ch++)
+	{
+		slope[ch]=0.0;
+		intercept[ch]=0.0;
+	}
+
+	if (num < 2 || numY < 1)return -1;
+	if (tsAlloc(&ts,num) != 0)return -3;
+
+	if (tsSetX(&ts,xdata,&x0) != 0)
+	{
+		tsFree(&ts);
+		return -2;
+	}
+
+	result=0;
+	for (ch=0;ch<numY;ch++)
+	{
+		if (tsFit(&ts,ydata+ch*num,x0,&slope[ch],&intercept[ch]) != 0) result=-2;
+	}
+
+	tsFree(&ts);
+
+	return result;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* ctimeToDbl: This function converts'timeString' to double value and returns it			*/
+/*																			   				*/
+/*  timeString must be a string containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	double ctimeToDbl (char *timeString)
+#else
+	DllExport double __cdecl ctimeToDbl (char *timeString)
+#endif
+{
+	double val;
+	sscanf(timeString,"%lg",&val);
+	return val;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToDDDHHMMSS_MS: This function converts'timeVal' to double value as DDDHHMMSS.sss		*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	double timeToDDDHHMMSS_MS (double timeVal)
+#else
+	DllExport double __cdecl timeToDDDHHMMSS_MS (double timeVal)
+#endif
+{
+	return timeVal/1000.0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToDDDHHMMSS: This function converts'timeVal' to double value as DDDHHMMSS			*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long timeToDDDHHMMSS (double timeVal)
+#else
+	DllExport long __cdecl timeToDDDHHMMSS (double timeVal)
+#endif
+{
+	double val;
+	long val2;
+
+	val=timeVal/1000.0;
+	val2=(long) val;
+
+	return val2;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToDay: This function extracts day from 'timeVal'										*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long timeToDay (double timeVal)
+#else
+	DllExport long __cdecl timeToDay (double timeVal)
+#endif
+{
+	double val;
+
+	val=timeVal/1000000000.0;
+
+	return (long) val;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToHour: This function extracts hour from 'timeVal'									*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long timeToHour (double timeVal)
+#else
+	DllExport long __cdecl timeToHour (double timeVal)
+#endif
+{
+	double val;
+	long val2;
+	long val3;
+
+	val=timeVal/1000000000.0;
+	val2=(long)val;
+
+	val=timeVal/10000000.0;
+	val3=(long)val;
+
+	val2=val3 - val2*100;
+
+	return val2;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToMinute: This function extracts minute from 'timeVal'								*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long timeToMinute (double timeVal)
+#else
+	DllExport long __cdecl timeToMinute (double timeVal)
+#endif
+{
+	double val;
+	long val2;
+	long val3;
+
+	val=timeVal/10000000.0;
+	val2=(long)val;
+
+	val=timeVal/100000.0;
+	val3=(long) val;
+
+	val2=val3 - val2*100;
+
+	return val2;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToSecond: This function extracts second from 'timeVal'								*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long timeToSecond (double timeVal)
+#else
+	DllExport long __cdecl timeToSecond (double timeVal)
+#endif
+{
+	double val;
+	long val2;
+	long val3;
+
+	val=timeVal/100000.0;
+	val2=(long)val;
+
+	val=timeVal/1000.0;
+	val3=(long) val;
+
+	val2=val3 - val2*100;
+
+	return val2;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToMillisec: This function extracts millisecond from 'timeVal'						*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long timeToMillisec (double timeVal)
+#else
+	DllExport long __cdecl timeToMillisec (double timeVal)
+#endif
+{
+	double val;
+	long val2;
+
+	val2=timeToDDDHHMMSS(timeVal);
+	val=(double)val2;
 
-*/
+	val=timeVal - val*1000;
+	val2=(long) val;
+
+	return val2;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToHHMMSS: This function extracts HHMMSS from 'timeVal'								*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	long sortDoublePtr (double *fdata, long num, char how, long *index)
+	long timeToHHMMSS (double timeVal)
 #else
-	DllExport long __cdecl sortDoublePtr (double *fdata, long num, char how, long *index)
+	DllExport long __cdecl timeToHHMMSS (double timeVal)
 #endif
 {
-	long ii,jj,noswap;
-	double temp;
-	char chow;
+	double val;
+	long val2;
+	long val3;
 
-	if (num < 1)return(-1);
-//	if (how != 'A' && how != 'a' && how != 'B' && how != 'b')return -1;	  // this has a bug Nuri  4-24-2007
-	if (how != 'A' && how != 'a' && how != 'D' && how != 'd')return -1;	  // fixed the bug  4-24-2007
+	val=timeVal/1000.0;
+	val2=(long) val;
 
-	for (ii=0;ii<num;ii++)index[ii]=ii;
-	if (num == 1)return(0);
+	val=timeVal/1000000000.0;
+	val3=(long) val;
 
-	chow=how;
-	if (chow == 'A')chow='a';
-	if (chow == 'D')chow='d';
+	val2=val2 - val3*1000000;
 
-	switch (chow)
-	{
-		case 'a':   /* assending */
-        for (ii=0;ii<num-1;ii++)
-		{
-			noswap=1;
-			for (jj=num-1;jj>ii;jj--)
-			{
-				if (fdata[index[jj]]<fdata[index[jj-1]])
-				{
-					temp=(double)index[jj];
-					index[jj]=index[jj-1];
-					index[jj-1]=(int)temp;
-					noswap=0;
-				}
-			}
-			if (noswap) return(0);
-        }
-		return (0);
+	return val2;
+}
 
-		case 'd':   /* descending */
-		for (ii=0;ii<num-1;ii++)
-		{
-			noswap=1;
-			for (jj=num-1;jj>ii;jj--)
-			{
-				if (fdata[index[jj]]>fdata[index[jj-1]])
-				{
-					temp=(double)index[jj];
-					index[jj]=index[jj-1];
-					index[jj-1]=(int)temp;
-					noswap=0;
-				}
-			}
-			if (noswap) return(0);
-		}
-		return (0);
-	}
-	return (-1);
+/********************************************************************************************/
+/*																							*/
+/* timeToHHMMSS_MS: This function extracts HHMMSS.sss from 'timeVal'						*/
+/*																			   				*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	double timeToHHMMSS_MS (double timeVal)
+#else
+	DllExport double __cdecl timeToHHMMSS_MS (double timeVal)
+#endif
+{
+	double val;
+	double val2;
+
+	val=timeToDDDHHMMSS_MS(timeVal);
+	val2=(double) timeToDay(timeVal);
+
+	val2=val - val2*1000000.0;
+
+	return val2;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* ctimeToDbl: This function converts'timeString' to double value and returns it			*/
+/* timeToDecDay: This function converts 'timeVal' to decimal day and returns it				*/
 /*																			   				*/
-/*  timeString must be a string containing DDDHHMMSSsss	(standard datum output)				*/
+/*  time must be a double containing DDDHHMMSSsss	(standard datum output)					*/
 /*		where:																				*/
 /*			DDD=julian day																	*/
 /*			HH =hour																		*/
@@ -318,20 +5079,73 @@ long error;
 /*																							*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	double ctimeToDbl (char *timeString)
+	double timeToDecDay (double timeVal)
 #else
-	DllExport double __cdecl ctimeToDbl (char *timeString)
+	DllExport double __cdecl timeToDecDay (double timeVal)
 #endif
 {
 	double val;
-	sscanf(timeString,"%lg",&val);
+	long day,hour,minute,second,millisec;
+	double result;
+
+	day=timeToDay(timeVal);
+	hour=timeToHour(timeVal);
+	minute=timeToMinute(timeVal);
+	second=timeToSecond(timeVal);
+	millisec=timeToMillisec(timeVal);
+
+	result=(double)day;
+
+	val=(double)hour;
+	val=val/24.0;
+	result=result+val;
+
+	val=(double)minute;
+	val=val/(24.0*60.0);
+	result=result+val;
+
+	val=(double)second;
+	val=val/(24.0*60.0*60.0);
+	result=result+val;
+
+	val=(double)millisec;
+	val=val/(24.0*60.0*60.0*1000.0);
+	result=result+val;
+
+	return result;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToYearSecond: This function converts 'timeVal' to seconds since the year began.		*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	double timeToYearSecond (double timeVal)
+#else
+	DllExport double __cdecl timeToYearSecond (double timeVal)
+#endif
+{
+	double val;
+
+	val=timeToDecDay(timeVal);
+	if(val < 1.0)return 0.0;
+
+	val=(val-1.0) * 24.0 * 60.0 * 60.0;
+
 	return val;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToDDDHHMMSS_MS: This function converts'timeVal' to double value as DDDHHMMSS.sss		*/
-/*																			   				*/
+/* timeToStdStr: This function converts 'timeVal' to 'strout' as 'DDD-HH:MM:SS.sss'			*/
 /*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
 /*		where:																				*/
 /*			DDD=julian day																	*/
@@ -340,395 +5154,898 @@ long error;
 /*			SS =second																		*/
 /*			sss=millisecond																	*/
 /*																							*/
+/*  Function always returns 0																*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	double timeToDDDHHMMSS_MS (double timeVal)
+	long timeToStdStr (double timeVal, char *strout)
 #else
-	DllExport double __cdecl timeToDDDHHMMSS_MS (double timeVal)
+	DllExport long __cdecl timeToStdStr (double timeVal, char *strout)
 #endif
 {
-	return timeVal/1000.0;
+	sprintf(strout,"%03d-%02d:%02d:%02d.%03d\0",timeToDay(timeVal),
+		timeToHour(timeVal),timeToMinute(timeVal),timeToSecond(timeVal),
+		timeToMillisec(timeVal));
+
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* timeToCtime: This function converts 'timeVal' to 'strout' as 'DDDHHMMSSsss'			*/
+/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
+/*		where:																				*/
+/*			DDD=julian day																	*/
+/*			HH =hour																		*/
+/*			MM =minute																		*/
+/*			SS =second																		*/
+/*			sss=millisecond																	*/
+/*																							*/
+/*  Function always returns 0																*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long timeToCtime (double timeVal, char *strout)
+#else
+	DllExport long __cdecl timeToCtime (double timeVal, char *strout)
+#endif
+{
+	sprintf(strout,"%03d%02d%02d%02d%03d\0",timeToDay(timeVal),
+		timeToHour(timeVal),timeToMinute(timeVal),timeToSecond(timeVal),
+		timeToMillisec(timeVal));
+
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* Time axis helpers for arrays of DDDHHMMSSsss values (standard datum output)				*/
+/*																							*/
+/*  timeToYearMillisec decodes one value with integer arithmetic.  It gives the same		*/
+/*  result as timeToYearSecond()*1000 without its rounding, and 0 if DDD is 0.				*/
+/*																							*/
+/*  timeUnwrapper turns a time ordered stream of such values into a continuous axis in		*/
+/*  seconds.  A backward jump of more than half a year (or of more than 12 hours when		*/
+/*  DDD is 0, i.e. time of day only) is taken as a year (day) rollover and the length of	*/
+/*  the year (366 days if the last day seen was 366) is added from then on.  Smaller		*/
+/*  backward steps are kept as they are (out of order samples).								*/
+/*																							*/
+/********************************************************************************************/
+static double timeToYearMillisec (double timeVal, long *day)
+{
+	long dddhhmmss, sod;
+	double millisec;
+
+	dddhhmmss=(long)(timeVal/1000.0);
+	millisec=(double)(long)(timeVal - (double)dddhhmmss*1000.0);
+
+	*day=dddhhmmss/1000000;
+	sod=((dddhhmmss/10000)%100)*3600 + ((dddhhmmss/100)%100)*60 + dddhhmmss%100;
+
+	if (*day < 1)return (double)sod*1000.0 + millisec;
+
+	return ((double)(*day-1)*86400.0 + (double)sod)*1000.0 + millisec;
+}
+
+typedef struct
+{
+	double	offset;			/* seconds added for rollovers so far */
+	double	lastRaw;		/* last decoded value in seconds, before offset */
+	long	lastDay;		/* DDD of last value */
+	long	started;
+} timeUnwrapper;
+
+static void timeUnwrapInit (timeUnwrapper *tu)
+{
+	tu->offset=0.0;
+	tu->lastRaw=0.0;
+	tu->lastDay=0;
+	tu->started=0;
+}
+
+/* next value of the stream in seconds on the continuous axis */
+static double timeUnwrapNext (timeUnwrapper *tu, double timeVal)
+{
+	double raw, period;
+	long day;
+
+	raw=timeToYearMillisec(timeVal,&day)/1000.0;
+
+	if (tu->started)
+	{
+		if (day < 1) period=86400.0;
+		else period=(tu->lastDay >= 366) ? 366.0*86400.0 : 365.0*86400.0;
+
+		if (raw < tu->lastRaw - period/2.0) tu->offset=tu->offset + period;
+	}
+
+	tu->started=1;
+	tu->lastRaw=raw;
+	tu->lastDay=day;
+
+	return raw + tu->offset;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToDDDHHMMSS: This function converts'timeVal' to double value as DDDHHMMSS			*/
-/*																			   				*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* timeIndexCreate: This function builds an index over 'timeData' for time window queries	*/
+/*																							*/
+/*  timeData must be an array of doubles containing DDDHHMMSSsss (standard datum output)	*/
+/*  num: number of values in timeData														*/
+/*																							*/
+/*  The index converts every value once to seconds elapsed since timeData[0], removing		*/
+/*  year (and day) rollovers.  It also keeps the running maximum of the elapsed times from	*/
+/*  the start and the running minimum from the end.  Both are ascending even when samples	*/
+/*  arrive out of order, so timeIndexRange can bracket a window with binary searches.		*/
 /*																							*/
+/*  Function returns the index, or NULL if num < 1 or out of memory.						*/
+/*  Release it with timeIndexFree															*/
 /********************************************************************************************/
+struct timeIndex
+{
+	long	num;
+	double	*elapsed;		/* seconds since timeData[0] */
+	double	*prefixMax;		/* max of elapsed[0..ii] */
+	double	*suffixMin;		/* min of elapsed[ii..num-1] */
+};
+typedef struct timeIndex timeIndex;
+
 #ifdef _HPUX_SOURCE
-	long timeToDDDHHMMSS (double timeVal)
+	timeIndex *timeIndexCreate (double *timeData, long num)
 #else
-	DllExport long __cdecl timeToDDDHHMMSS (double timeVal)
+	DllExport timeIndex * __cdecl timeIndexCreate (double *timeData, long num)
 #endif
 {
-	double val;
-	long val2;
+	timeIndex *ti;
+	timeUnwrapper tu;
+	double first;
+	long ii;
 
-	val=timeVal/1000.0;
-	val2=(long) val;
+	if (num < 1)return NULL;
 
-	return val2;
+	ti=(timeIndex *)malloc(sizeof(timeIndex));
+	if (ti == NULL)return NULL;
+
+	ti->num=num;
+	ti->elapsed=(double *)malloc(num*sizeof(double));
+	ti->prefixMax=(double *)malloc(num*sizeof(double));
+	ti->suffixMin=(double *)malloc(num*sizeof(double));
+	if (ti->elapsed == NULL || ti->prefixMax == NULL || ti->suffixMin == NULL)
+	{
+		free(ti->elapsed);
+		free(ti->prefixMax);
+		free(ti->suffixMin);
+		free(ti);
+		return NULL;
+	}
+
+	timeUnwrapInit(&tu);
+	first=timeUnwrapNext(&tu,timeData[0]);
+	ti->elapsed[0]=0.0;
+	ti->prefixMax[0]=0.0;
+	for (ii=1;ii<num;ii++)
+	{
+		ti->elapsed[ii]=timeUnwrapNext(&tu,timeData[ii]) - first;
+		ti->prefixMax[ii]=(ti->elapsed[ii] > ti->prefixMax[ii-1]) ? ti->elapsed[ii] : ti->prefixMax[ii-1];
+	}
+
+	ti->suffixMin[num-1]=ti->elapsed[num-1];
+	for (ii=num-2;ii>=0;ii--)
+	{
+		ti->suffixMin[ii]=(ti->elapsed[ii] < ti->suffixMin[ii+1]) ? ti->elapsed[ii] : ti->suffixMin[ii+1];
+	}
+
+	return ti;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToDay: This function extracts day from 'timeVal'										*/
-/*																			   				*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* timeIndexFree: This function releases an index created by timeIndexCreate				*/
 /*																							*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	long timeToDay (double timeVal)
+	void timeIndexFree (timeIndex *ti)
 #else
-	DllExport long __cdecl timeToDay (double timeVal)
+	DllExport void __cdecl timeIndexFree (timeIndex *ti)
 #endif
 {
-	double val;
-
-	val=timeVal/1000000000.0;
+	if (ti == NULL)return;
 
-	return (long) val;
+	free(ti->elapsed);
+	free(ti->prefixMax);
+	free(ti->suffixMin);
+	free(ti);
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToHour: This function extracts hour from 'timeVal'									*/
-/*																			   				*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* timeIndexElapsed: This function returns seconds elapsed from the first sample to sample	*/
+/*  'index' (rollovers removed), or 0 if 'index' is out of range							*/
 /*																							*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	long timeToHour (double timeVal)
+	double timeIndexElapsed (timeIndex *ti, long index)
 #else
-	DllExport long __cdecl timeToHour (double timeVal)
+	DllExport double __cdecl timeIndexElapsed (timeIndex *ti, long index)
 #endif
 {
-	double val;
-	long val2;
-	long val3;
+	if (index < 0 || index >= ti->num)return 0.0;
 
-	val=timeVal/1000000000.0;
-	val2=(long)val;
+	return ti->elapsed[index];
+}
 
-	val=timeVal/10000000.0;
-	val3=(long)val;
+/* first ii in [lo, hi) with values[ii] >= tt (values is ascending there) */
+static long timeIndexLowerBound (double *values, long lo, long hi, double tt)
+{
+	long mid;
 
-	val2=val3 - val2*100;
+	while (lo < hi)
+	{
+		mid=lo + (hi - lo)/2;
+		if (values[mid] < tt) lo=mid+1;
+		else hi=mid;
+	}
 
-	return val2;
+	return lo;
+}
+
+/* adds samples lo to hi-1 to the ranges found, joining them to the last range if adjacent
+   (lastEnd is the end of the last range, kept even when that range did not fit) */
+static void timeIndexAddRange (long lo, long hi, long *startIndex, long *endIndex, long maxRanges, long *nfound, long *lastEnd)
+{
+	if (lo >= hi)return;
+
+	if (*nfound > 0 && *lastEnd == lo)
+	{
+		if (*nfound <= maxRanges) endIndex[*nfound-1]=hi;
+		*lastEnd=hi;
+		return;
+	}
+
+	if (*nfound < maxRanges)
+	{
+		startIndex[*nfound]=lo;
+		endIndex[*nfound]=hi;
+	}
+	(*nfound)++;
+	*lastEnd=hi;
+}
+
+/* adds the samples of [lo, hi) that are inside of [t0, t1), one by one */
+static void timeIndexScan (timeIndex *ti, long lo, long hi, double t0, double t1, long *startIndex, long *endIndex, long maxRanges, long *nfound, long *lastEnd)
+{
+	long ii;
+
+	for (ii=lo;ii<hi;ii++)
+	{
+		if (ti->elapsed[ii] >= t0 && ti->elapsed[ii] < t1) timeIndexAddRange(ii,ii+1,startIndex,endIndex,maxRanges,nfound,lastEnd);
+	}
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToMinute: This function extracts minute from 'timeVal'								*/
-/*																			   				*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* timeIndexRange: This function finds the samples with elapsed time in [t0, t1)			*/
+/*																							*/
+/*  ti: index from timeIndexCreate															*/
+/*  t0, t1: window in seconds elapsed since the first sample (i.e. 120 and 180)			*/
+/*  startIndex, endIndex: returned sample ranges; samples startIndex[k] to endIndex[k]-1	*/
+/*		are inside of the window.  For time ordered data there is at most one range		*/
+/*  maxRanges: size of startIndex and endIndex												*/
+/*  numRanges: returned number of ranges found												*/
+/*																							*/
+/*  Four binary searches on the running maximum and minimum split the data in three:		*/
+/*  samples that are certainly inside of the window (one block, not scanned), and the		*/
+/*  samples at each edge of the window whose running maximum and minimum straddle t0 or		*/
+/*  t1.  Only these edge samples are checked one by one.  For time ordered data the edges	*/
+/*  are empty and the cost is O(log num).  A late sample only widens an edge by the			*/
+/*  distance it arrived out of place, so jitter does not turn a query into a scan.  (A		*/
+/*  corrupt time far ahead of the data would widen the edges up to where the data catches	*/
+/*  up with it; such a file is better split or cleaned first.)								*/
 /*																							*/
+/*  Function returns 0 if no error, -1 if t1 < t0 or maxRanges < 1, -2 if more than		*/
+/*	maxRanges ranges were found (numRanges is the number needed, the first maxRanges		*/
+/*	ranges are returned)																	*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	long timeToMinute (double timeVal)
+	long timeIndexRange (timeIndex *ti, double t0, double t1, long *startIndex, long *endIndex, long maxRanges, long *numRanges)
 #else
-	DllExport long __cdecl timeToMinute (double timeVal)
+	DllExport long __cdecl timeIndexRange (timeIndex *ti, double t0, double t1, long *startIndex, long *endIndex, long maxRanges, long *numRanges)
 #endif
 {
-	double val;
-	long val2;
-	long val3;
+	long lo, inLo, inHi, hi, nfound, lastEnd;
 
-	val=timeVal/10000000.0;
-	val2=(long)val;
+	*numRanges=0;
+	if (t1 < t0 || maxRanges < 1)return -1;
 
-	val=timeVal/100000.0;
-	val3=(long) val;
+	/* samples before lo are all < t0 and samples from hi on are all >= t1 */
+	lo=timeIndexLowerBound(ti->prefixMax,0,ti->num,t0);
+	hi=timeIndexLowerBound(ti->suffixMin,lo,ti->num,t1);
 
-	val2=val3 - val2*100;
+	/* samples in [inLo, inHi) are all in the window */
+	inLo=timeIndexLowerBound(ti->suffixMin,lo,hi,t0);
+	inHi=timeIndexLowerBound(ti->prefixMax,lo,hi,t1);
 
-	return val2;
+	nfound=0;
+	lastEnd=-1;
+	if (inLo < inHi)
+	{
+		timeIndexScan(ti,lo,inLo,t0,t1,startIndex,endIndex,maxRanges,&nfound,&lastEnd);
+		timeIndexAddRange(inLo,inHi,startIndex,endIndex,maxRanges,&nfound,&lastEnd);
+		timeIndexScan(ti,inHi,hi,t0,t1,startIndex,endIndex,maxRanges,&nfound,&lastEnd);
+	}
+	else timeIndexScan(ti,lo,hi,t0,t1,startIndex,endIndex,maxRanges,&nfound,&lastEnd);
+
+	*numRanges=nfound;
+	if (nfound > maxRanges)return -2;
+
+	return 0;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToSecond: This function extracts second from 'timeVal'								*/
-/*																			   				*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* Steady state detection (steadyDetect...)													*/
 /*																							*/
+/*  A channel is steady when, over the last 'windowSec' seconds, the least square slope is	*/
+/*  within +-maxSlope (units per minute) and max - min is within maxSpread.  Each new		*/
+/*  sample costs O(1) on average: the fit is a rolling lscfMoments (added and removed as	*/
+/*  samples enter and leave the window, rebuilt once per window length to drop rounding),	*/
+/*  and min and max come from monotonic queues of sample numbers.  Sample times are			*/
+/*  DDDHHMMSSsss values, unwrapped over day and year rollovers as in timeIndexCreate.		*/
+/*  The window grows its buffers as needed to hold all samples within windowSec.			*/
 /********************************************************************************************/
-#ifdef _HPUX_SOURCE
-	long timeToSecond (double timeVal)
-#else
-	DllExport long __cdecl timeToSecond (double timeVal)
-#endif
+struct steadyDetect
 {
-	double val;
-	long val2;
-	long val3;
+	double	windowSec;
+	double	maxSlope;
+	double	maxSpread;
+	long	capacity;
+	double	*tbuf;			/* unwrapped seconds */
+	double	*vbuf;			/* values */
+	double	*rawTime;		/* time values as given */
+	long	*minQueue;		/* sample numbers, values ascending */
+	long	*maxQueue;		/* sample numbers, values descending */
+	long	first;			/* oldest sample number in the window */
+	long	next;			/* next sample number */
+	long	minHead, minTail;
+	long	maxHead, maxTail;
+	long	sinceRefresh;
+	double	startSec;		/* time of the first sample */
+	lscfMoments	mm;
+	timeUnwrapper	tu;
+	long	state;			/* 1 steady, 0 not */
+	long	numChanges;
+	double	changeTime;		/* time value of the last change */
+	double	steadySince;	/* unwrapped seconds when it became steady */
+};
+typedef struct steadyDetect steadyDetect;
+
+static void steadyDetectClear (steadyDetect *sd)
+{
+	sd->first=0;
+	sd->next=0;
+	sd->minHead=0;
+	sd->minTail=0;
+	sd->maxHead=0;
+	sd->maxTail=0;
+	sd->sinceRefresh=0;
+	sd->startSec=0.0;
+	sd->state=0;
+	sd->numChanges=0;
+	sd->changeTime=0.0;
+	sd->steadySince=0.0;
+	lscfMomentsInit(&sd->mm);
+	timeUnwrapInit(&sd->tu);
+}
 
-	val=timeVal/100000.0;
-	val2=(long)val;
+/* doubles the buffers, keeping sample numbers (slot = number % capacity) */
+static long steadyDetectGrow (steadyDetect *sd)
+{
+	double *tbuf, *vbuf, *rawTime;
+	long *minQueue, *maxQueue;
+	long cap, nn;
+
+	cap=2*sd->capacity;
+	tbuf=(double *)malloc(cap*sizeof(double));
+	vbuf=(double *)malloc(cap*sizeof(double));
+	rawTime=(double *)malloc(cap*sizeof(double));
+	minQueue=(long *)malloc(cap*sizeof(long));
+	maxQueue=(long *)malloc(cap*sizeof(long));
+	if (tbuf == NULL || vbuf == NULL || rawTime == NULL || minQueue == NULL || maxQueue == NULL)
+	{
+		free(tbuf);
+		free(vbuf);
+		free(rawTime);
+		free(minQueue);
+		free(maxQueue);
+		return -1;
+	}
 
-	val=timeVal/1000.0;
-	val3=(long) val;
+	for (nn=sd->first;nn<sd->next;nn++)
+	{
+		tbuf[nn%cap]=sd->tbuf[nn%sd->capacity];
+		vbuf[nn%cap]=sd->vbuf[nn%sd->capacity];
+		rawTime[nn%cap]=sd->rawTime[nn%sd->capacity];
+	}
+	for (nn=sd->minHead;nn<sd->minTail;nn++) minQueue[nn%cap]=sd->minQueue[nn%sd->capacity];
+	for (nn=sd->maxHead;nn<sd->maxTail;nn++) maxQueue[nn%cap]=sd->maxQueue[nn%sd->capacity];
+
+	free(sd->tbuf);
+	free(sd->vbuf);
+	free(sd->rawTime);
+	free(sd->minQueue);
+	free(sd->maxQueue);
+	sd->tbuf=tbuf;
+	sd->vbuf=vbuf;
+	sd->rawTime=rawTime;
+	sd->minQueue=minQueue;
+	sd->maxQueue=maxQueue;
+	sd->capacity=cap;
 
-	val2=val3 - val2*100;
+	return 0;
+}
 
-	return val2;
+/* rebuilds the fit from the samples in the window */
+static void steadyDetectRefresh (steadyDetect *sd)
+{
+	long pos, count, span;
+
+	lscfMomentsInit(&sd->mm);
+
+	pos=sd->first%sd->capacity;
+	count=sd->next - sd->first;
+	span=(sd->capacity - pos < count) ? sd->capacity - pos : count;
+
+	lscfMomentsAddArray(&sd->mm,sd->tbuf+pos,sd->vbuf+pos,span);
+	lscfMomentsAddArray(&sd->mm,sd->tbuf,sd->vbuf,count-span);
+
+	sd->sinceRefresh=0;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToMillisec: This function extracts millisecond from 'timeVal'						*/
-/*																			   				*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* steadyDetectCreate: This function creates a steady state detector for one channel		*/
 /*																							*/
+/*  windowSec: length of the window in seconds												*/
+/*  maxSlope: largest steady slope, in value units per minute (absolute value)				*/
+/*  maxSpread: largest steady max - min over the window										*/
+/*																							*/
+/*  Function returns the detector, or NULL if windowSec <= 0 or out of memory.  Release it	*/
+/*  with steadyDetectFree																	*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	long timeToMillisec (double timeVal)
+	steadyDetect *steadyDetectCreate (double windowSec, double maxSlope, double maxSpread)
 #else
-	DllExport long __cdecl timeToMillisec (double timeVal)
+	DllExport steadyDetect * __cdecl steadyDetectCreate (double windowSec, double maxSlope, double maxSpread)
 #endif
 {
-	double val;
-	long val2;
-
-	val2=timeToDDDHHMMSS(timeVal);
-	val=(double)val2;
+	steadyDetect *sd;
+
+	if (!(windowSec > 0.0))return NULL;
+
+	sd=(steadyDetect *)malloc(sizeof(steadyDetect));
+	if (sd == NULL)return NULL;
+
+	sd->windowSec=windowSec;
+	sd->maxSlope=fabs(maxSlope);
+	sd->maxSpread=maxSpread;
+	sd->capacity=64;
+	sd->tbuf=(double *)malloc(sd->capacity*sizeof(double));
+	sd->vbuf=(double *)malloc(sd->capacity*sizeof(double));
+	sd->rawTime=(double *)malloc(sd->capacity*sizeof(double));
+	sd->minQueue=(long *)malloc(sd->capacity*sizeof(long));
+	sd->maxQueue=(long *)malloc(sd->capacity*sizeof(long));
+	if (sd->tbuf == NULL || sd->vbuf == NULL || sd->rawTime == NULL || sd->minQueue == NULL || sd->maxQueue == NULL)
+	{
+		free(sd->tbuf);
+		free(sd->vbuf);
+		free(sd->rawTime);
+		free(sd->minQueue);
+		free(sd->maxQueue);
+		free(sd);
+		return NULL;
+	}
 
-	val=timeVal - val*1000;
-	val2=(long) val;
+	steadyDetectClear(sd);
 
-	return val2;
+	return sd;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToHHMMSS: This function extracts HHMMSS from 'timeVal'								*/
-/*																			   				*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* steadyDetectFree: This function releases a detector from steadyDetectCreate				*/
 /*																							*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	long timeToHHMMSS (double timeVal)
+	void steadyDetectFree (steadyDetect *sd)
 #else
-	DllExport long __cdecl timeToHHMMSS (double timeVal)
+	DllExport void __cdecl steadyDetectFree (steadyDetect *sd)
 #endif
 {
-	double val;
-	long val2;
-	long val3;
-
-	val=timeVal/1000.0;
-	val2=(long) val;
-
-	val=timeVal/1000000000.0;
-	val3=(long) val;
-
-	val2=val2 - val3*1000000;
-
-	return val2;
+	if (sd == NULL)return;
+
+	free(sd->tbuf);
+	free(sd->vbuf);
+	free(sd->rawTime);
+	free(sd->minQueue);
+	free(sd->maxQueue);
+	free(sd);
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToHHMMSS_MS: This function extracts HHMMSS.sss from 'timeVal'						*/
-/*																			   				*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* steadyDetectReset: This function empties a detector, for a new test point				*/
 /*																							*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	double timeToHHMMSS_MS (double timeVal)
+	void steadyDetectReset (steadyDetect *sd)
 #else
-	DllExport double __cdecl timeToHHMMSS_MS (double timeVal)
+	DllExport void __cdecl steadyDetectReset (steadyDetect *sd)
 #endif
 {
-	double val;
-	double val2;
-
-	val=timeToDDDHHMMSS_MS(timeVal);
-	val2=(double) timeToDay(timeVal);
-
-	val2=val - val2*1000000.0;
-
-	return val2;
+	if (sd != NULL) steadyDetectClear(sd);
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToDecDay: This function converts 'timeVal' to decimal day and returns it				*/
-/*																			   				*/
-/*  time must be a double containing DDDHHMMSSsss	(standard datum output)					*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* steadyDetectAdd: This function adds one sample to a detector and returns the state		*/
 /*																							*/
+/*  timeVal: sample time DDDHHMMSSsss (standard datum output), not decreasing				*/
+/*  value: sample value																		*/
+/*  slope: returned slope over the window, per minute										*/
+/*  spread: returned max - min over the window												*/
+/*  changed: returned 1 if the state changed at this sample, else 0							*/
+/*																							*/
+/*  The channel is not steady until the samples cover at least windowSec.					*/
+/*																							*/
+/*  Function returns 1 if steady, 0 if not steady, -1 if sd is NULL or out of memory,		*/
+/*  -2 if timeVal is before the previous sample (the sample is ignored)						*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	double timeToDecDay (double timeVal)
+	long steadyDetectAdd (steadyDetect *sd, double timeVal, double value, double *slope, double *spread, long *changed)
 #else
-	DllExport double __cdecl timeToDecDay (double timeVal)
+	DllExport long __cdecl steadyDetectAdd (steadyDetect *sd, double timeVal, double value, double *slope, double *spread, long *changed)
 #endif
 {
-	double val;
-	long day,hour,minute,second,millisec;
-	double result;
+	timeUnwrapper tu;
+	double tt, aa, bb, rr;
+	long slot, steady;
 
-	day=timeToDay(timeVal);
-	hour=timeToHour(timeVal);
-	minute=timeToMinute(timeVal);
-	second=timeToSecond(timeVal);
-	millisec=timeToMillisec(timeVal);
+	*slope=0.0;
+	*spread=0.0;
+	*changed=0;
 
-	result=(double)day;
+	if (sd == NULL)return -1;
 
-	val=(double)hour;
-	val=val/24.0;
-	result=result+val;
+	tu=sd->tu;
+	tt=timeUnwrapNext(&tu,timeVal);
+	if (sd->next > sd->first && tt < sd->tbuf[(sd->next-1)%sd->capacity])return -2;
 
-	val=(double)minute;
-	val=val/(24.0*60.0);
-	result=result+val;
+	if (sd->next - sd->first == sd->capacity)
+	{
+		if (steadyDetectGrow(sd) != 0)return -1;
+	}
+	sd->tu=tu;
+	if (sd->next == 0) sd->startSec=tt;
+
+	slot=sd->next%sd->capacity;
+	sd->tbuf[slot]=tt;
+	sd->vbuf[slot]=value;
+	sd->rawTime[slot]=timeVal;
+	lscfMomentsAdd(&sd->mm,tt,value);
+
+	while (sd->minTail > sd->minHead && sd->vbuf[sd->minQueue[(sd->minTail-1)%sd->capacity]%sd->capacity] >= value) sd->minTail--;
+	sd->minQueue[(sd->minTail++)%sd->capacity]=sd->next;
+	while (sd->maxTail > sd->maxHead && sd->vbuf[sd->maxQueue[(sd->maxTail-1)%sd->capacity]%sd->capacity] <= value) sd->maxTail--;
+	sd->maxQueue[(sd->maxTail++)%sd->capacity]=sd->next;
+	sd->next++;
+
+	/* drop samples older than the window */
+	while (tt - sd->tbuf[sd->first%sd->capacity] > sd->windowSec)
+	{
+		slot=sd->first%sd->capacity;
+		lscfMomentsRemove(&sd->mm,sd->tbuf[slot],sd->vbuf[slot]);
+		if (sd->minQueue[sd->minHead%sd->capacity] == sd->first) sd->minHead++;
+		if (sd->maxQueue[sd->maxHead%sd->capacity] == sd->first) sd->maxHead++;
+		sd->first++;
+		sd->sinceRefresh++;
+	}
+	if (sd->sinceRefresh >= sd->next - sd->first) steadyDetectRefresh(sd);
 
-	val=(double)second;
-	val=val/(24.0*60.0*60.0);
-	result=result+val;
+	*spread=sd->vbuf[sd->maxQueue[sd->maxHead%sd->capacity]%sd->capacity] - sd->vbuf[sd->minQueue[sd->minHead%sd->capacity]%sd->capacity];
+	lscfMomentsResult(&sd->mm,&aa,&bb,&rr);
+	if (sd->mm.sXX > 0.0) *slope=aa*60.0;
 
-	val=(double)millisec;
-	val=val/(24.0*60.0*60.0*1000.0);
-	result=result+val;
+	steady=(tt - sd->startSec >= sd->windowSec && sd->mm.sXX > 0.0 && fabs(*slope) <= sd->maxSlope && *spread <= sd->maxSpread);
+	if (steady != sd->state)
+	{
+		sd->state=steady;
+		sd->numChanges++;
+		sd->changeTime=timeVal;
+		if (steady) sd->steadySince=tt;
+		*changed=1;
+	}
 
-	return result;
+	return steady;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToYearSecond: This function converts 'timeVal' to seconds since the year began.		*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* steadyDetectLastChange: This function returns the last state change of a detector		*/
+/*																							*/
+/*  timeVal: returned time of the sample where the state changed, DDDHHMMSSsss				*/
+/*  timeStr: returned time as 'DDD-HH:MM:SS.sss' (timeToStdStr), at least 17 characters.	*/
+/*		May be NULL																			*/
+/*  steadySec: returned seconds the channel has been steady up to the last sample (0 if not	*/
+/*		steady)																				*/
 /*																							*/
+/*  Function returns the state changed to (1 steady, 0 not steady), -1 if sd is NULL or		*/
+/*  the state never changed																	*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	double timeToYearSecond (double timeVal)
+	long steadyDetectLastChange (steadyDetect *sd, double *timeVal, char *timeStr, double *steadySec)
 #else
-	DllExport double __cdecl timeToYearSecond (double timeVal)
+	DllExport long __cdecl steadyDetectLastChange (steadyDetect *sd, double *timeVal, char *timeStr, double *steadySec)
 #endif
 {
-	double val;
+	*timeVal=0.0;
+	*steadySec=0.0;
+	if (timeStr != NULL) timeStr[0]='\0';
 
-	val=timeToDecDay(timeVal);
-	if(val < 1.0)return 0.0;
+	if (sd == NULL || sd->numChanges == 0)return -1;
 
-	val=(val-1.0) * 24.0 * 60.0 * 60.0;
+	*timeVal=sd->changeTime;
+	if (timeStr != NULL) timeToStdStr(sd->changeTime,timeStr);
+	if (sd->state) *steadySec=sd->tbuf[(sd->next-1)%sd->capacity] - sd->steadySince;
 
-	return val;
+	return sd->state;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToStdStr: This function converts 'timeVal' to 'strout' as 'DDD-HH:MM:SS.sss'			*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* steadyDetect_array: This function runs a steady state detector over a whole record		*/
 /*																							*/
-/*  Function always returns 0																*/
+/*  timeData: sample times DDDHHMMSSsss, not decreasing										*/
+/*  valueData: sample values																*/
+/*  num: number of samples																	*/
+/*  windowSec, maxSlope, maxSpread: as steadyDetectCreate									*/
+/*  state: returned state at each sample, 1 steady or 0 not (may be NULL)					*/
+/*  maxTrans: size of transIndex															*/
+/*  transIndex: returned indices where the state changed (the state at transIndex[k] is the	*/
+/*		new state).  timeData[transIndex[k]] is the time of the change						*/
+/*  numTrans: returned number of state changes (may be more than maxTrans; only maxTrans	*/
+/*		are stored)																			*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 1 or windowSec <= 0, -2 if the time goes	*/
+/*  backwards (that sample is skipped and keeps the previous state), -3 if out of memory	*/
 /********************************************************************************************/
 #ifdef _HPUX_SOURCE
-	long timeToStdStr (double timeVal, char *strout)
+	long steadyDetect_array (double *timeData, double *valueData, long num, double windowSec, double maxSlope, double maxSpread, long *state, long maxTrans, long *transIndex, long *numTrans)
 #else
-	DllExport long __cdecl timeToStdStr (double timeVal, char *strout)
+	DllExport long __cdecl steadyDetect_array (double *timeData, double *valueData, long num, double windowSec, double maxSlope, double maxSpread, long *state, long maxTrans, long *transIndex, long *numTrans)
 #endif
 {
-	sprintf(strout,"%03d-%02d:%02d:%02d.%03d\0",timeToDay(timeVal),
-		timeToHour(timeVal),timeToMinute(timeVal),timeToSecond(timeVal),
-		timeToMillisec(timeVal));
+	steadyDetect *sd;
+	double slope, spread;
+	long ii, st, changed, result;
 
-	return 0;
+	*numTrans=0;
+
+	if (num < 1 || !(windowSec > 0.0))return -1;
+
+	sd=steadyDetectCreate(windowSec,maxSlope,maxSpread);
+	if (sd == NULL)return -3;
+
+	result=0;
+	for (ii=0;ii<num;ii++)
+	{
+		st=steadyDetectAdd(sd,timeData[ii],valueData[ii],&slope,&spread,&changed);
+		if (st == -1)
+		{
+			result=-3;
+			break;
+		}
+		if (st == -2)
+		{
+			result=-2;
+			st=sd->state;
+		}
+		if (state != NULL) state[ii]=st;
+		if (changed)
+		{
+			if (*numTrans < maxTrans) transIndex[*numTrans]=ii;
+			(*numTrans)++;
+		}
+	}
+
+	steadyDetectFree(sd);
+
+	return result;
 }
 
 /********************************************************************************************/
 /*																							*/
-/* timeToCtime: This function converts 'timeVal' to 'strout' as 'DDDHHMMSSsss'			*/
-/*  timeVal must be a double containing DDDHHMMSSsss	(standard datum output)				*/
-/*		where:																				*/
-/*			DDD=julian day																	*/
-/*			HH =hour																		*/
-/*			MM =minute																		*/
-/*			SS =second																		*/
-/*			sss=millisecond																	*/
+/* rateOfChange_array: This function computes the time derivative dy/dt of a channel with	*/
+/*  DDDHHMMSSsss time stamps, which may be irregular and may roll over a day or year		*/
+/*  boundary (the times are unwrapped as in timeIndexCreate).								*/
 /*																							*/
-/*  Function always returns 0																*/
+/*  Times are decoded and the derivative computed in one pass: the last 2*halfWidth+2		*/
+/*  decoded samples are kept in a small ring buffer, and each derivative is written as		*/
+/*  soon as the samples it needs have been read.  Near the ends of the record the window	*/
+/*  is cut short.																			*/
+/*																							*/
+/*  timeData: sample times DDDHHMMSSsss, increasing											*/
+/*  valueData: sample values																*/
+/*  num: number of samples																	*/
+/*  mode:	'c' or 'C' central difference over samples i-halfWidth, i, i+halfWidth			*/
+/*			(second order for uneven spacing; one sided at the ends)						*/
+/*			'r' or 'R' slope of the least square line over samples i-halfWidth to			*/
+/*			i+halfWidth																		*/
+/*			's' or 'S' Savitzky-Golay: slope at sample i of the least square cubic over		*/
+/*			samples i-halfWidth to i+halfWidth (lower order if fewer than 4 samples)		*/
+/*  halfWidth: half window width in samples (>= 1)											*/
+/*  dydt: returned derivative at each sample, value units per second						*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 2, halfWidth < 1 or mode is not known,		*/
+/*  -2 if the times are not increasing (dydt is set to 0 from there on), -3 if out of		*/
+/*  memory																					*/
 /********************************************************************************************/
+
+/* slope at tr[ii] of the least square polynomial of 'order' through ring samples lo..hi */
+static double rocLocalFit (const double *tr, const double *yr, long ring, long lo, long hi, long ii, long order)
+{
+	double aa[4][5], uu, yy, pw, span, t0, y0, temp;
+	long jj, kk, row, col, piv, nc;
+
+	nc=hi - lo + 1;
+	if (order > nc - 1) order=nc - 1;
+
+	t0=tr[ii%ring];
+	y0=yr[ii%ring];
+	span=0.0;
+	for (jj=lo;jj<=hi;jj++) if (fabs(tr[jj%ring] - t0) > span) span=fabs(tr[jj%ring] - t0);
+
+	for (row=0;row<=order;row++) for (col=0;col<=order+1;col++) aa[row][col]=0.0;
+
+	/* normal equations in u=(t-t0)/span */
+	for (jj=lo;jj<=hi;jj++)
+	{
+		uu=(tr[jj%ring] - t0)/span;
+		yy=yr[jj%ring] - y0;
+		pw=1.0;
+		for (row=0;row<=order;row++)
+		{
+			temp=pw;
+			for (col=0;col<=order;col++)
+			{
+				aa[row][col]=aa[row][col] + temp;
+				temp=temp*uu;
+			}
+			aa[row][order+1]=aa[row][order+1] + pw*yy;
+			pw=pw*uu;
+		}
+	}
+
+	/* Gaussian elimination with partial pivoting */
+	for (col=0;col<=order;col++)
+	{
+		piv=col;
+		for (row=col+1;row<=order;row++) if (fabs(aa[row][col]) > fabs(aa[piv][col])) piv=row;
+		if (aa[piv][col] == 0.0)return 0.0;
+		for (kk=0;kk<=order+1;kk++)
+		{
+			temp=aa[col][kk];
+			aa[col][kk]=aa[piv][kk];
+			aa[piv][kk]=temp;
+		}
+		for (row=col+1;row<=order;row++)
+		{
+			temp=aa[row][col]/aa[col][col];
+			for (kk=col;kk<=order+1;kk++) aa[row][kk]=aa[row][kk] - temp*aa[col][kk];
+		}
+	}
+	for (row=order;row>=1;row--)
+	{
+		temp=aa[row][order+1];
+		for (kk=row+1;kk<=order;kk++) temp=temp - aa[row][kk]*aa[kk][order+1];
+		aa[row][order+1]=temp/aa[row][row];
+	}
+
+	return aa[1][order+1]/span;
+}
+
+/* central difference at ii from ring samples lo and hi */
+static double rocCentral (const double *tr, const double *yr, long ring, long lo, long hi, long ii)
+{
+	double h1, h2, ya, yb, yc;
+
+	if (ii == lo)return (yr[hi%ring] - yr[ii%ring])/(tr[hi%ring] - tr[ii%ring]);
+	if (ii == hi)return (yr[ii%ring] - yr[lo%ring])/(tr[ii%ring] - tr[lo%ring]);
+
+	h1=tr[ii%ring] - tr[lo%ring];
+	h2=tr[hi%ring] - tr[ii%ring];
+	ya=yr[lo%ring];
+	yb=yr[ii%ring];
+	yc=yr[hi%ring];
+
+	return (h1*h1*(yc - yb) + h2*h2*(yb - ya))/(h1*h2*(h1 + h2));
+}
+
 #ifdef _HPUX_SOURCE
-	long timeToCtime (double timeVal, char *strout)
+	long rateOfChange_array (double *timeData, double *valueData, long num, char mode, long halfWidth, double *dydt)
 #else
-	DllExport long __cdecl timeToCtime (double timeVal, char *strout)
+	DllExport long __cdecl rateOfChange_array (double *timeData, double *valueData, long num, char mode, long halfWidth, double *dydt)
 #endif
 {
-	sprintf(strout,"%03d%02d%02d%02d%03d\0",timeToDay(timeVal),
-		timeToHour(timeVal),timeToMinute(timeVal),timeToSecond(timeVal),
-		timeToMillisec(timeVal));
+	timeUnwrapper tu;
+	lscfMoments mm;
+	double *tr, *yr, aa, bb, rr;
+	long ring, jj, ii, lo, hi, added, removed, sinceRefresh, kk, result;
+
+	if (num < 2 || halfWidth < 1)return -1;
+	if (mode != 'c' && mode != 'C' && mode != 'r' && mode != 'R' && mode != 's' && mode != 'S')return -1;
+	if (halfWidth > num) halfWidth=num;
+
+	ring=2*halfWidth + 2;		/* window plus the sample leaving it */
+	tr=(double *)malloc(ring*sizeof(double));
+	yr=(double *)malloc(ring*sizeof(double));
+	if (tr == NULL || yr == NULL)
+	{
+		free(tr);
+		free(yr);
+		return -3;
+	}
 
-	return 0;
+	timeUnwrapInit(&tu);
+	lscfMomentsInit(&mm);
+	added=0;
+	removed=0;
+	sinceRefresh=0;
+	result=0;
+
+	/* jj is the sample read, ii the sample whose window [lo,hi] is complete */
+	for (jj=0;jj<num+halfWidth;jj++)
+	{
+		if (jj < num)
+		{
+			tr[jj%ring]=timeUnwrapNext(&tu,timeData[jj]);
+			yr[jj%ring]=valueData[jj];
+			if (jj > 0 && tr[jj%ring] <= tr[(jj-1)%ring])
+			{
+				for (ii=(jj-halfWidth > 0) ? jj-halfWidth : 0;ii<num;ii++) dydt[ii]=0.0;
+				result=-2;
+				break;
+			}
+		}
+
+		ii=jj - halfWidth;
+		if (ii < 0)continue;
+		lo=(ii - halfWidth > 0) ? ii - halfWidth : 0;
+		hi=(ii + halfWidth < num - 1) ? ii + halfWidth : num - 1;
+
+		if (mode == 'c' || mode == 'C') dydt[ii]=rocCentral(tr,yr,ring,lo,hi,ii);
+		else if (mode == 's' || mode == 'S') dydt[ii]=rocLocalFit(tr,yr,ring,lo,hi,ii,3);
+		else
+		{
+			/* rolling fit over [lo,hi], rebuilt once per window to drop rounding */
+			for (;added<=hi;added++) lscfMomentsAdd(&mm,tr[added%ring],yr[added%ring]);
+			for (;removed<lo;removed++)
+			{
+				lscfMomentsRemove(&mm,tr[removed%ring],yr[removed%ring]);
+				sinceRefresh++;
+			}
+			if (sinceRefresh >= ring)
+			{
+				lscfMomentsInit(&mm);
+				for (kk=lo;kk<=hi;kk++) lscfMomentsAdd(&mm,tr[kk%ring],yr[kk%ring]);
+				sinceRefresh=0;
+			}
+			lscfMomentsResult(&mm,&aa,&bb,&rr);
+			dydt[ii]=aa;
+		}
+	}
+
+	free(tr);
+	free(yr);
+
+	return result;
 }
 
 /********************************************************************************************/
@@ -2280,10 +7597,381 @@ long error;
 	if (volts == 0.0) return 0.0;
 	if (refTemp == 32.0)return tct_V32toF (volts);
 
-	refVolts=tct_FtoV32(refTemp);
-	if (refVolts == 0.0)return 0.0;
+	refVolts=tct_FtoV32(refTemp);
+	if (refVolts == 0.0)return 0.0;
+
+	return tct_V32toF((refVolts+volts));
+}
+
+/********************************************************************************************/
+/*																							*/
+/* Channel statistics (chanStats...)														*/
+/*																							*/
+/*  A chanStats accumulator keeps the count, minimum and maximum with their indices, mean,	*/
+/*  sum of squared deviations from the mean (M2), sum of squares and the number of values	*/
+/*  below and above a pair of limits, in one pass over the data.  Data is taken in blocks	*/
+/*  of CHAN_STATS_BLOCK values: min, max and sums run in 4 independent lanes, the block's	*/
+/*  M2 is taken about the block mean while the block is still in cache, and the block is	*/
+/*  merged into the totals (Chan et al. update).  Two accumulators can be merged the same	*/
+/*  way, for data processed in pieces or on several threads.								*/
+/*																							*/
+/*  Indices count from the first value added since create or reset.  When accumulators		*/
+/*  are merged, the data of the second one is taken to follow the data of the first.		*/
+/********************************************************************************************/
+#define CHAN_STATS_BLOCK	256
+
+struct chanStats
+{
+	double	count;
+	double	mean;
+	double	m2;
+	double	sumSq;
+	double	minVal;
+	double	maxVal;
+	double	minIndex;
+	double	maxIndex;
+	double	lowLimit;
+	double	highLimit;
+	double	numBelow;
+	double	numAbove;
+};
+typedef struct chanStats chanStats;
+
+/* dest = aa followed by bb (dest may be aa or bb) */
+static void chanStatsCombine (chanStats *dest, const chanStats *aa, const chanStats *bb)
+{
+	chanStats res;
+	double delta;
+
+	if (bb->count == 0.0)
+	{
+		*dest=*aa;
+		return;
+	}
+	if (aa->count == 0.0)
+	{
+		res=*bb;
+		res.lowLimit=aa->lowLimit;
+		res.highLimit=aa->highLimit;
+		*dest=res;
+		return;
+	}
+
+	res=*aa;
+	res.count=aa->count + bb->count;
+	delta=bb->mean - aa->mean;
+	res.mean=aa->mean + delta*(bb->count/res.count);
+	res.m2=aa->m2 + bb->m2 + delta*delta*(aa->count*bb->count/res.count);
+	res.sumSq=aa->sumSq + bb->sumSq;
+	if (bb->minVal < aa->minVal)
+	{
+		res.minVal=bb->minVal;
+		res.minIndex=aa->count + bb->minIndex;
+	}
+	if (bb->maxVal > aa->maxVal)
+	{
+		res.maxVal=bb->maxVal;
+		res.maxIndex=aa->count + bb->maxIndex;
+	}
+	res.numBelow=aa->numBelow + bb->numBelow;
+	res.numAbove=aa->numAbove + bb->numAbove;
+
+	*dest=res;
+}
+
+/* statistics of one block of up to CHAN_STATS_BLOCK values, added to 'stats' */
+static void chanStatsAddBlock (chanStats *stats, const double *data, long num)
+{
+	chanStats blk;
+	double mn[4], mx[4], sum[4], sq[4], below[4], above[4];
+	long mnAt[4], mxAt[4];
+	double low, high, dd, d0, d1, d2, d3;
+	long ii, kk;
+
+	low=stats->lowLimit;
+	high=stats->highLimit;
+	for (kk=0;kk<4;kk++)
+	{
+		mn[kk]=data[0];
+		mx[kk]=data[0];
+		mnAt[kk]=0;
+		mxAt[kk]=0;
+		sum[kk]=0.0;
+		sq[kk]=0.0;
+		below[kk]=0.0;
+		above[kk]=0.0;
+	}
+
+	for (ii=0;ii+4<=num;ii+=4)
+	{
+		for (kk=0;kk<4;kk++)
+		{
+			dd=data[ii+kk];
+			if (dd < mn[kk]) { mn[kk]=dd; mnAt[kk]=ii+kk; }
+			if (dd > mx[kk]) { mx[kk]=dd; mxAt[kk]=ii+kk; }
+			sum[kk]=sum[kk] + dd;
+			sq[kk]=sq[kk] + dd*dd;
+			below[kk]=below[kk] + (dd < low);
+			above[kk]=above[kk] + (dd > high);
+		}
+	}
+	for (;ii<num;ii++)
+	{
+		dd=data[ii];
+		if (dd < mn[0]) { mn[0]=dd; mnAt[0]=ii; }
+		if (dd > mx[0]) { mx[0]=dd; mxAt[0]=ii; }
+		sum[0]=sum[0] + dd;
+		sq[0]=sq[0] + dd*dd;
+		below[0]=below[0] + (dd < low);
+		above[0]=above[0] + (dd > high);
+	}
+
+	/* lanes -> block, first index wins on ties */
+	blk.lowLimit=low;
+	blk.highLimit=high;
+	blk.count=(double)num;
+	blk.minVal=mn[0];
+	blk.maxVal=mx[0];
+	blk.minIndex=(double)mnAt[0];
+	blk.maxIndex=(double)mxAt[0];
+	for (kk=1;kk<4;kk++)
+	{
+		if (mn[kk] < blk.minVal || (mn[kk] == blk.minVal && mnAt[kk] < blk.minIndex))
+		{
+			blk.minVal=mn[kk];
+			blk.minIndex=(double)mnAt[kk];
+		}
+		if (mx[kk] > blk.maxVal || (mx[kk] == blk.maxVal && mxAt[kk] < blk.maxIndex))
+		{
+			blk.maxVal=mx[kk];
+			blk.maxIndex=(double)mxAt[kk];
+		}
+	}
+	blk.mean=((sum[0] + sum[1]) + (sum[2] + sum[3]))/blk.count;
+	blk.sumSq=(sq[0] + sq[1]) + (sq[2] + sq[3]);
+	blk.numBelow=(below[0] + below[1]) + (below[2] + below[3]);
+	blk.numAbove=(above[0] + above[1]) + (above[2] + above[3]);
+
+	/* M2 about the block mean, second pass over the cached block */
+	d0=0.0;
+	d1=0.0;
+	d2=0.0;
+	d3=0.0;
+	for (ii=0;ii+4<=num;ii+=4)
+	{
+		d0=d0 + (data[ii] - blk.mean)*(data[ii] - blk.mean);
+		d1=d1 + (data[ii+1] - blk.mean)*(data[ii+1] - blk.mean);
+		d2=d2 + (data[ii+2] - blk.mean)*(data[ii+2] - blk.mean);
+		d3=d3 + (data[ii+3] - blk.mean)*(data[ii+3] - blk.mean);
+	}
+	for (;ii<num;ii++) d0=d0 + (data[ii] - blk.mean)*(data[ii] - blk.mean);
+	blk.m2=(d0 + d1) + (d2 + d3);
+
+	chanStatsCombine(stats,stats,&blk);
+}
+
+/********************************************************************************************/
+/*																							*/
+/* chanStatsCreate: This function creates an empty statistics accumulator.  Values below	*/
+/*  'lowLimit' or above 'highLimit' are counted as out of range.							*/
+/*																							*/
+/*  Function returns the accumulator, or NULL if out of memory.  Release it with			*/
+/*  chanStatsFree																			*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	chanStats *chanStatsCreate (double lowLimit, double highLimit)
+#else
+	DllExport chanStats * __cdecl chanStatsCreate (double lowLimit, double highLimit)
+#endif
+{
+	chanStats *stats;
+
+	stats=(chanStats *)malloc(sizeof(chanStats));
+	if (stats == NULL)return NULL;
+
+	memset(stats,0,sizeof(chanStats));
+	stats->lowLimit=lowLimit;
+	stats->highLimit=highLimit;
+
+	return stats;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* chanStatsFree: This function releases an accumulator from chanStatsCreate				*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	void chanStatsFree (chanStats *stats)
+#else
+	DllExport void __cdecl chanStatsFree (chanStats *stats)
+#endif
+{
+	free(stats);
+}
+
+/********************************************************************************************/
+/*																							*/
+/* chanStatsReset: This function empties an accumulator, keeping its limits					*/
+/*																							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	void chanStatsReset (chanStats *stats)
+#else
+	DllExport void __cdecl chanStatsReset (chanStats *stats)
+#endif
+{
+	double lowLimit, highLimit;
+
+	if (stats == NULL)return;
+
+	lowLimit=stats->lowLimit;
+	highLimit=stats->highLimit;
+	memset(stats,0,sizeof(chanStats));
+	stats->lowLimit=lowLimit;
+	stats->highLimit=highLimit;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* chanStatsAddArray: This function adds 'num' values of 'data' to an accumulator			*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if stats is NULL or num < 0							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long chanStatsAddArray (chanStats *stats, double *data, long num)
+#else
+	DllExport long __cdecl chanStatsAddArray (chanStats *stats, double *data, long num)
+#endif
+{
+	long ii, nb;
+
+	if (stats == NULL || num < 0)return -1;
+
+	for (ii=0;ii<num;ii+=CHAN_STATS_BLOCK)
+	{
+		nb=(num - ii < CHAN_STATS_BLOCK) ? num - ii : CHAN_STATS_BLOCK;
+		chanStatsAddBlock(stats,data+ii,nb);
+	}
+
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* chanStatsMerge: This function sets 'dest' to the statistics of the data of 'stats1'		*/
+/*  followed by the data of 'stats2'.  dest may be stats1 or stats2.  The limits of stats1	*/
+/*  are kept.																				*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if an argument is NULL								*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long chanStatsMerge (chanStats *dest, chanStats *stats1, chanStats *stats2)
+#else
+	DllExport long __cdecl chanStatsMerge (chanStats *dest, chanStats *stats1, chanStats *stats2)
+#endif
+{
+	if (dest == NULL || stats1 == NULL || stats2 == NULL)return -1;
+
+	chanStatsCombine(dest,stats1,stats2);
+
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* chanStatsResult: This function returns the statistics of an accumulator					*/
+/*																							*/
+/*  count: number of values																	*/
+/*  mean: mean value																		*/
+/*  stdDev: sample standard deviation, sqrt(M2/(count-1)) (0 if count < 2)					*/
+/*  sumSq: sum of the squared values														*/
+/*  minVal, minIndex: smallest value and index of its first occurrence						*/
+/*  maxVal, maxIndex: largest value and index of its first occurrence						*/
+/*  numBelow, numAbove: number of values below lowLimit and above highLimit					*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if stats is NULL or empty							*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long chanStatsResult (chanStats *stats, double *count, double *mean, double *stdDev, double *sumSq, double *minVal, double *minIndex, double *maxVal, double *maxIndex, double *numBelow, double *numAbove)
+#else
+	DllExport long __cdecl chanStatsResult (chanStats *stats, double *count, double *mean, double *stdDev, double *sumSq, double *minVal, double *minIndex, double *maxVal, double *maxIndex, double *numBelow, double *numAbove)
+#endif
+{
+	*count=0.0;
+	*mean=0.0;
+	*stdDev=0.0;
+	*sumSq=0.0;
+	*minVal=0.0;
+	*minIndex=0.0;
+	*maxVal=0.0;
+	*maxIndex=0.0;
+	*numBelow=0.0;
+	*numAbove=0.0;
+
+	if (stats == NULL || stats->count == 0.0)return -1;
+
+	*count=stats->count;
+	*mean=stats->mean;
+	if (stats->count > 1.0) *stdDev=sqrt(stats->m2/(stats->count - 1.0));
+	*sumSq=stats->sumSq;
+	*minVal=stats->minVal;
+	*minIndex=stats->minIndex;
+	*maxVal=stats->maxVal;
+	*maxIndex=stats->maxIndex;
+	*numBelow=stats->numBelow;
+	*numAbove=stats->numAbove;
+
+	return 0;
+}
+
+/********************************************************************************************/
+/*																							*/
+/* tcV32toF_array: This function converts an array of thermocouple voltages (cold junction	*/
+/*  at 32 deg F) to temperatures in deg F, as tc?_V32toF, and optionally adds the			*/
+/*  temperatures to a chanStats accumulator in the same pass.  Statistics are taken per		*/
+/*  block of CHAN_STATS_BLOCK values right after the block is converted, while it is		*/
+/*  still in cache.																			*/
+/*																							*/
+/*  tcType: thermocouple type 'B', 'E', 'J', 'K', 'N', 'R', 'S' or 'T' (or lower case)		*/
+/*  volts: num voltages in volts															*/
+/*  tempF: returned num temperatures in deg F (may be the same array as volts)				*/
+/*  stats: accumulator from chanStatsCreate, or NULL for no statistics						*/
+/*																							*/
+/*  Function returns 0 if no error, -1 if num < 0, -2 if tcType is not known				*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	long tcV32toF_array (char tcType, double *volts, long num, double *tempF, chanStats *stats)
+#else
+	DllExport long __cdecl tcV32toF_array (char tcType, double *volts, long num, double *tempF, chanStats *stats)
+#endif
+{
+	double (*conv)(double);
+	long ii, jj, nb;
+
+	if (num < 0)return -1;
+
+	switch (tcType)
+	{
+		case 'B': case 'b': conv=tcb_V32toF; break;
+		case 'E': case 'e': conv=tce_V32toF; break;
+		case 'J': case 'j': conv=tcj_V32toF; break;
+		case 'K': case 'k': conv=tck_V32toF; break;
+		case 'N': case 'n': conv=tcn_V32toF; break;
+		case 'R': case 'r': conv=tcr_V32toF; break;
+		case 'S': case 's': conv=tcs_V32toF; break;
+		case 'T': case 't': conv=tct_V32toF; break;
+		default: return -2;
+	}
+
+	for (ii=0;ii<num;ii+=CHAN_STATS_BLOCK)
+	{
+		nb=(num - ii < CHAN_STATS_BLOCK) ? num - ii : CHAN_STATS_BLOCK;
+		for (jj=ii;jj<ii+nb;jj++) tempF[jj]=conv(volts[jj]);
+		if (stats != NULL) chanStatsAddBlock(stats,tempF+ii,nb);
+	}
 
-	return tct_V32toF((refVolts+volts));
+	return 0;
 }
 
 /********************************************************************************************/
@@ -3460,173 +9148,752 @@ long error;
    return tf;
 }
 
-/********************************************************************************************/
-/*
-	Written by: Nuri Cankurt March 10, 2004
+/********************************************************************************************/
+/*
+	Written by: Nuri Cankurt March 10, 2004
+
+	rtd_PT100A385_FtoOhm: This function calculates resistance in ohm for 100 ohm Platinum RTD
+	with Alpha coefficient of 0.00385
+
+    The equations are valid for -200 degC (-328 degF) to +850 degC (1562 degF)
+
+
+	Calling parameters:
+
+	tempInDegF:		temperature in deg F
+
+	Function return resistance in ohm.  If the values are outside the valid range, function returns 0 ohm
+
+*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	double rtd_PT100A385_FtoOhm (double tempInDegF)
+#else
+	DllExport double __cdecl rtd_PT100A385_FtoOhm (double tempInDegF)
+#endif
+{
+   double ohm;  
+
+   if (tempInDegF == 32.0) return 100.0;
+
+//   ohm=rtd_PTgenA385_FtoOhm2 (tempInDegF, 100.0);
+   ohm=rtd_PTgen_FtoOhm (tempInDegF, 100.0, 0.0, 0.0, 0.0);	// Nuri Cankurt 9-29-2008
+
+   return ohm;
+}
+
+/********************************************************************************************/
+/*
+	Written by: Nuri Cankurt March 10, 2004
+
+	rtd_PT500A385_FtoOhm: This function calculates resistance in ohm for 500 ohm Platinum RTD
+	with Alpha coefficient of 0.00385
+
+    The equations are valid for -200 degC (-328 degF) to +850 degC (1562 degF)
+
+
+	Calling parameters:
+
+	tempInDegF:		temperature in deg F
+
+	Function return resistance in ohm.  If the values are outside the valid range, function returns 0 ohm
+
+*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	double rtd_PT500A385_FtoOhm (double tempInDegF)
+#else
+	DllExport double __cdecl rtd_PT500A385_FtoOhm (double tempInDegF)
+#endif
+{
+   double ohm;  
+
+   if (tempInDegF == 32.0) return 500.0;
+
+//   ohm=rtd_PTgenA385_FtoOhm2 (tempInDegF, 500.0);
+   ohm=rtd_PTgen_FtoOhm (tempInDegF, 500.0, 0.0, 0.0, 0.0);	// Nuri Cankurt 9-29-2008
+
+   return ohm;
+}
+
+/********************************************************************************************/
+/*
+	Written by: Nuri Cankurt March 10, 2004
+
+	rtd_PT1000A385_FtoOhm: This function calculates resistance in ohm for 1000 ohm Platinum RTD
+	with Alpha coefficient of 0.00385
+
+    The equations are valid for -200 degC (-328 degF) to +850 degC (1562 degF)
+
+
+	Calling parameters:
+
+	tempInDegF:		temperature in deg F
+
+	Function return resistance in ohm.  If the values are outside the valid range, function returns 0 ohm
+
+*/
+/********************************************************************************************/
+#ifdef _HPUX_SOURCE
+	double rtd_PT1000A385_FtoOhm (double tempInDegF)
+#else
+	DllExport double __cdecl rtd_PT1000A385_FtoOhm (double tempInDegF)
+#endif
+{
+   double ohm;  /* deg F */
+
+   if (tempInDegF == 32.0) return 1000.0;
+
+//   ohm=rtd_PTgenA385_FtoOhm2 (tempInDegF, 1000.0);
+   ohm=rtd_PTgen_FtoOhm (tempInDegF, 1000.0, 0.0, 0.0, 0.0);	// Nuri Cankurt 9-29-2008
+
+   return ohm;
+}
+
+/********************************************************************************/
+/*																				*/
+/* polyValue: This function returns result of a polynomial equation				*/
+/*																				*/
+/*	xval: X value for which polynomial function is calculated					*/
+/*  coef: Coeefients for polynomial function 0th, 1st, 2nd,.....Nth	order		*/
+/*  order:  Polynomial function order (i.e. 9 for 9th order polynomial			*/
+/*	if (order=0)polyValue=coef[0]												*/
+/*  if (order>0)polyValue=coef[0]+coef[1]*xval+coef[2]*xval^2 +..+coef[N]*xval^N*/
+/*  if (order<0)polyValue=coef[0]+coef[1]/xval+coef[2]/xval^2 +..+coef[N]/xval^N*/
+/********************************************************************************/
+#ifdef _HPUX_SOURCE
+	double polyValue (double *coef, double xval, long order)
+#else
+	DllExport double __cdecl polyValue (double *coef, double xval, long order)
+#endif
+{
+	long	orderUsed;
+	long	ii;
+	double	result;	
+	double	lastFactor;
+	double	factor;
+
+	orderUsed=order;
+
+	if (order == 0)
+	{
+		return coef[0];
+	}
+	else
+	if (order > 0)
+	{
+		if (xval == 0.0)return coef[0];
+	}
+	else
+	if (order < 0)
+	{
+		if (xval == 0.0)return 0.0; /* error */
+		orderUsed=(-1)*order;
+	}
+
+	result=coef[0];
+	lastFactor=1.0;
+
+	if (order > 0)
+	{
+		for (ii=1;ii<=orderUsed;ii++)
+		{
+			factor=lastFactor*xval;
+			result=result + coef[ii]*factor;
+			lastFactor=factor;
+		}
+	}
+	else
+	if (order < 0)
+	{
+		for (ii=1;ii<=orderUsed;ii++)
+		{
+			factor=lastFactor*xval;
+			result=result + coef[ii]/factor;
+			lastFactor=factor;
+		}
+	}
+
+	return result;
+}
+
+/********************************************************************************/
+/*																				*/
+/* polyValueInv: This function returns the inverse power polynomial of		*/
+/*	polyValue with a negative order:											*/
+/*   coef[0]+coef[1]/xval+coef[2]/xval^2 +..+coef[N]/xval^N, N=|order|			*/
+/*	(order may be given as for polyValue, -N, or as N).  1/xval is computed		*/
+/*	once and the polynomial in u=1/xval is evaluated with Horner's rule, so		*/
+/*	an order N evaluation costs one division instead of N.						*/
+/*																				*/
+/*	The result differs from polyValue(coef, xval, -N) by at most				*/
+/*	(5N+1)*2^-53*S, where S=|coef[0]|+|coef[1]/xval|+..+|coef[N]/xval^N|.		*/
+/*	When all terms have the same sign S is |result| and the bound is (5N+1)		*/
+/*	units in the last place.  If the terms cancel, both forms lose the same		*/
+/*	accuracy relative to S.														*/
+/*																				*/
+/*	If xval=0 the function returns 0.0 (error), as polyValue does				*/
+/********************************************************************************/
+#ifdef _HPUX_SOURCE
+	double polyValueInv (double *coef, double xval, long order)
+#else
+	DllExport double __cdecl polyValueInv (double *coef, double xval, long order)
+#endif
+{
+	double uu, result;
+	long ii, nn;
+
+	nn=(order < 0) ? -order : order;
+	if (nn == 0)return coef[0];
+	if (xval == 0.0)return 0.0; /* error */
+
+	uu=1.0/xval;
+	result=coef[nn];
+	for (ii=nn-1;ii>=0;ii--) result=result*uu + coef[ii];
+
+	return result;
+}
+
+/********************************************************************************/
+/*																				*/
+/* polyValue_array: This function returns polyValue(coef, xdata[ii], order)	*/
+/*	for 'num' x values.  The polynomial is evaluated with Horner's rule, four	*/
+/*	x values at a time: the four chains are independent, so they overlap in	*/
+/*	the pipeline (and vectorize where the compiler can), and the loop has no	*/
+/*	branch on x.  Results match polyValue to rounding.							*/
+/*																				*/
+/*  coef, order: as for polyValue												*/
+/*  xdata: num X values															*/
+/*  ydata: returned num values.  As with polyValue, x=0 gives coef[0] for a		*/
+/*   positive order and 0.0 for a negative order								*/
+/*																				*/
+/*  For a negative order 1/x is computed once per x and the polynomial in 1/x	*/
+/*   is evaluated as by polyValueInv (see there for the error bound)			*/
+/*																				*/
+/* Function returns 0 if no error, -1 if num < 1, -2 if order < 0 and one or	*/
+/*	more x values are 0															*/
+/********************************************************************************/
+#define POLY_LANES	4
+
+#ifdef _HPUX_SOURCE
+	long polyValue_array (double *coef, long order, double *xdata, double *ydata, long num)
+#else
+	DllExport long __cdecl polyValue_array (double *coef, long order, double *xdata, double *ydata, long num)
+#endif
+{
+	double acc[POLY_LANES], xv[POLY_LANES], tv[POLY_LANES];
+	long ii, jj, ll, nn, numZero;
+
+	if (num < 1)return -1;
+
+	if (order == 0)
+	{
+		for (ii=0;ii<num;ii++) ydata[ii]=coef[0];
+		return 0;
+	}
+
+	nn=(order > 0) ? order : -order;
+	numZero=0;
+
+	for (ii=0;ii<num;ii+=POLY_LANES)
+	{
+		if (ii + POLY_LANES > num)
+		{
+			/* tail: repeat the last x in the unused lanes */
+			for (ll=0;ll<POLY_LANES;ll++) xv[ll]=xdata[(ii + ll < num) ? ii + ll : num - 1];
+		}
+		else
+		{
+			for (ll=0;ll<POLY_LANES;ll++) xv[ll]=xdata[ii+ll];
+		}
+
+		/* Horner in t=x, or t=1/x for a negative order */
+		if (order > 0) for (ll=0;ll<POLY_LANES;ll++) tv[ll]=xv[ll];
+		else for (ll=0;ll<POLY_LANES;ll++) tv[ll]=(xv[ll] == 0.0) ? 0.0 : 1.0/xv[ll];
+
+		for (ll=0;ll<POLY_LANES;ll++) acc[ll]=coef[nn];
+		for (jj=nn-1;jj>=0;jj--)
+		{
+			for (ll=0;ll<POLY_LANES;ll++) acc[ll]=acc[ll]*tv[ll] + coef[jj];
+		}
+
+		for (ll=0;ll<POLY_LANES;ll++) if (xv[ll] == 0.0) acc[ll]=(order > 0) ? coef[0] : 0.0;
+
+		for (ll=0;ll<POLY_LANES && ii+ll<num;ll++)
+		{
+			ydata[ii+ll]=acc[ll];
+			if (order < 0 && xv[ll] == 0.0) numZero++;
+		}
+	}
+
+	if (numZero > 0)return -2;
+	return 0;
+}
+
+/********************************************************************************/
+/*																				*/
+/* Polynomial function handle (polyFunc...)										*/
+/*																				*/
+/* polyFuncCreate copies the coefficients and picks a kernel made for the		*/
+/* order: for orders 1 to POLY_MAX_UNROLL the Horner steps are written out by	*/
+/* the macros below, so an evaluation is one call through a function pointer	*/
+/* with no loop over the terms.  Higher orders use a Horner loop.  A negative	*/
+/* order evaluates the same kernel at 1/x, as polyValueInv does.				*/
+/********************************************************************************/
+#define POLY_MAX_UNROLL	16
+
+/* c[0] + x*(c[1] + x*(c[2] + ...)), nn+1 coefficients */
+#define POLY_MUL_1(c,x)		((c)[0] + (x)*(c)[1])
+#define POLY_MUL_2(c,x)		((c)[0] + (x)*POLY_MUL_1((c)+1,x))
+#define POLY_MUL_3(c,x)		((c)[0] + (x)*POLY_MUL_2((c)+1,x))
+#define POLY_MUL_4(c,x)		((c)[0] + (x)*POLY_MUL_3((c)+1,x))
+#define POLY_MUL_5(c,x)		((c)[0] + (x)*POLY_MUL_4((c)+1,x))
+#define POLY_MUL_6(c,x)		((c)[0] + (x)*POLY_MUL_5((c)+1,x))
+#define POLY_MUL_7(c,x)		((c)[0] + (x)*POLY_MUL_6((c)+1,x))
+#define POLY_MUL_8(c,x)		((c)[0] + (x)*POLY_MUL_7((c)+1,x))
+#define POLY_MUL_9(c,x)		((c)[0] + (x)*POLY_MUL_8((c)+1,x))
+#define POLY_MUL_10(c,x)	((c)[0] + (x)*POLY_MUL_9((c)+1,x))
+#define POLY_MUL_11(c,x)	((c)[0] + (x)*POLY_MUL_10((c)+1,x))
+#define POLY_MUL_12(c,x)	((c)[0] + (x)*POLY_MUL_11((c)+1,x))
+#define POLY_MUL_13(c,x)	((c)[0] + (x)*POLY_MUL_12((c)+1,x))
+#define POLY_MUL_14(c,x)	((c)[0] + (x)*POLY_MUL_13((c)+1,x))
+#define POLY_MUL_15(c,x)	((c)[0] + (x)*POLY_MUL_14((c)+1,x))
+#define POLY_MUL_16(c,x)	((c)[0] + (x)*POLY_MUL_15((c)+1,x))
+
+typedef double (*polyKernel) (const double *coef, long nn, double x);
+
+#define POLY_KERNELS(nn) \
+	static double polyMul##nn (const double *coef, long terms, double x) { (void)terms; return POLY_MUL_##nn(coef,x); }
+
+POLY_KERNELS(1)
+POLY_KERNELS(2)
+POLY_KERNELS(3)
+POLY_KERNELS(4)
+POLY_KERNELS(5)
+POLY_KERNELS(6)
+POLY_KERNELS(7)
+POLY_KERNELS(8)
+POLY_KERNELS(9)
+POLY_KERNELS(10)
+POLY_KERNELS(11)
+POLY_KERNELS(12)
+POLY_KERNELS(13)
+POLY_KERNELS(14)
+POLY_KERNELS(15)
+POLY_KERNELS(16)
+
+static double polyConst (const double *coef, long nn, double x)
+{
+	(void)nn;
+	(void)x;
+	return coef[0];
+}
+
+static double polyMulLoop (const double *coef, long nn, double x)
+{
+	double result;
+	long ii;
+
+	result=coef[nn];
+	for (ii=nn-1;ii>=0;ii--) result=result*x + coef[ii];
+	return result;
+}
+
+static const polyKernel polyMulKernels[POLY_MAX_UNROLL+1]=
+{
+	polyConst, polyMul1, polyMul2, polyMul3, polyMul4, polyMul5, polyMul6, polyMul7, polyMul8,
+	polyMul9, polyMul10, polyMul11, polyMul12, polyMul13, polyMul14, polyMul15, polyMul16
+};
+
+struct polyFunc
+{
+	long		order;
+	long		nn;				/* number of terms after coef[0] */
+	int			inverse;		/* negative order: kernel is evaluated at 1/x */
+	double		zeroValue;		/* value at x=0 (polyValue conventions) */
+	polyKernel	kernel;
+	double		*coef;
+};
+typedef struct polyFunc polyFunc;
+
+/********************************************************************/
+/*                                                                  */
+/* polyFuncCreate: This function creates a handle for the			*/
+/*	polynomial of polyValue(coef, x, order).  The coefficients		*/
+/*	(|order|+1 values) are copied.									*/
+/*																	*/
+/* Function returns the handle, or NULL if out of memory.  Release	*/
+/*	it with polyFuncFree											*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	polyFunc *polyFuncCreate (double *coef, long order)
+#else
+	DllExport polyFunc * __cdecl polyFuncCreate (double *coef, long order)
+#endif
+{
+	polyFunc *pf;
+	long nn;
+
+	nn=(order < 0) ? -order : order;
 
-	rtd_PT100A385_FtoOhm: This function calculates resistance in ohm for 100 ohm Platinum RTD
-	with Alpha coefficient of 0.00385
+	pf=(polyFunc *)malloc(sizeof(polyFunc));
+	if (pf == NULL)return NULL;
+	pf->coef=(double *)malloc((nn + 1)*sizeof(double));
+	if (pf->coef == NULL)
+	{
+		free(pf);
+		return NULL;
+	}
+	memcpy(pf->coef,coef,(nn + 1)*sizeof(double));
 
-    The equations are valid for -200 degC (-328 degF) to +850 degC (1562 degF)
+	pf->order=order;
+	pf->nn=nn;
+	pf->inverse=(order < 0);
+	pf->zeroValue=(order < 0) ? 0.0 : coef[0];
+	pf->kernel=(nn > POLY_MAX_UNROLL) ? polyMulLoop : polyMulKernels[nn];
 
+	return pf;
+}
 
-	Calling parameters:
+/********************************************************************/
+/*                                                                  */
+/* polyFuncFree: This function releases a polynomial handle			*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	void polyFuncFree (polyFunc *pf)
+#else
+	DllExport void __cdecl polyFuncFree (polyFunc *pf)
+#endif
+{
+	if (pf == NULL)return;
 
-	tempInDegF:		temperature in deg F
+	free(pf->coef);
+	free(pf);
+}
 
-	Function return resistance in ohm.  If the values are outside the valid range, function returns 0 ohm
+/********************************************************************/
+/*                                                                  */
+/* polyFuncValue: This function returns the polynomial at xval,		*/
+/*	the same as polyValue(coef, xval, order) to rounding (for a		*/
+/*	negative order within the bound given for polyValueInv)			*/
+/********************************************************************/
+#ifdef _HPUX_SOURCE
+	double polyFuncValue (polyFunc *pf, double xval)
+#else
+	DllExport double __cdecl polyFuncValue (polyFunc *pf, double xval)
+#endif
+{
+	if (xval == 0.0)return pf->zeroValue;
+	if (pf->inverse) xval=1.0/xval;
 
-*/
-/********************************************************************************************/
+	return pf->kernel(pf->coef,pf->nn,xval);
+}
+
+/********************************************************************/
+/*                                                                  */
+/* polyFuncValue_array: This function returns the polynomial at		*/
+/*	'num' x values (see polyFuncValue)								*/
+/*																	*/
+/* Function returns 0 if no error, -1 if num < 1, -2 if the order	*/
+/*	is negative and one or more x values are 0 (their value is 0.0)	*/
+/********************************************************************/
 #ifdef _HPUX_SOURCE
-	double rtd_PT100A385_FtoOhm (double tempInDegF)
+	long polyFuncValue_array (polyFunc *pf, double *xdata, double *ydata, long num)
 #else
-	DllExport double __cdecl rtd_PT100A385_FtoOhm (double tempInDegF)
+	DllExport long __cdecl polyFuncValue_array (polyFunc *pf, double *xdata, double *ydata, long num)
 #endif
 {
-   double ohm;  
+	polyKernel kernel;
+	double *coef;
+	long ii, nn, numZero;
 
-   if (tempInDegF == 32.0) return 100.0;
+	if (num < 1)return -1;
 
-//   ohm=rtd_PTgenA385_FtoOhm2 (tempInDegF, 100.0);
-   ohm=rtd_PTgen_FtoOhm (tempInDegF, 100.0, 0.0, 0.0, 0.0);	// Nuri Cankurt 9-29-2008
+	kernel=pf->kernel;
+	coef=pf->coef;
+	nn=pf->nn;
+	numZero=0;
+	for (ii=0;ii<num;ii++)
+	{
+		if (xdata[ii] == 0.0)
+		{
+			ydata[ii]=pf->zeroValue;
+			numZero++;
+		}
+		else if (pf->inverse) ydata[ii]=kernel(coef,nn,1.0/xdata[ii]);
+		else ydata[ii]=kernel(coef,nn,xdata[ii]);
+	}
 
-   return ohm;
+	if (pf->order < 0 && numZero > 0)return -2;
+	return 0;
 }
 
-/********************************************************************************************/
-/*
-	Written by: Nuri Cankurt March 10, 2004
+/********************************************************************************/
+/*																				*/
+/* Polynomial least square fit, producing coefficients for polyValue.			*/
+/*																				*/
+/*  The design matrix has columns 1, x, x^2, ... (or 1, 1/x, 1/x^2, ... for a	*/
+/*  negative order).  Each column is scaled by its largest value and the		*/
+/*  matrix is factored with Householder QR, which avoids the squared condition	*/
+/*  number of the normal equations.  The factorization depends only on xdata,	*/
+/*  so polyFit_multi factors once and solves for every channel.					*/
+/********************************************************************************/
+typedef struct
+{
+	long	num;		/* rows */
+	long	ncoef;		/* columns = |order| + 1 */
+	double	*qr;		/* num x ncoef column major: R above the diagonal, */
+						/* Householder vectors on and below it */
+	double	*rdiag;		/* diagonal of R */
+	double	*beta;		/* Householder factors */
+	double	*scale;		/* column scale factors */
+} polyFitQR;
+
+static void polyFitFree (polyFitQR *pq)
+{
+	free(pq->qr);
+	free(pq->rdiag);
+	free(pq->beta);
+	free(pq->scale);
+}
 
-	rtd_PT500A385_FtoOhm: This function calculates resistance in ohm for 500 ohm Platinum RTD
-	with Alpha coefficient of 0.00385
+/* builds and factors the design matrix.  Returns 0, -1, -2, -3 or -4 as polyFit */
+static long polyFitFactor (polyFitQR *pq, double *xdata, long num, long order)
+{
+	long ii, jj, cc, ncoef;
+	double *col, *vv;
+	double val, norm, alpha, ss, maxDiag;
 
-    The equations are valid for -200 degC (-328 degF) to +850 degC (1562 degF)
+	pq->qr=NULL;
+	pq->rdiag=NULL;
+	pq->beta=NULL;
+	pq->scale=NULL;
 
+	ncoef=(order < 0) ? 1-order : 1+order;
+	if (num < ncoef)return -1;
 
-	Calling parameters:
+	if (order < 0)
+	{
+		for (ii=0;ii<num;ii++) if (xdata[ii] == 0.0)return -2;
+	}
 
-	tempInDegF:		temperature in deg F
+	pq->num=num;
+	pq->ncoef=ncoef;
+	pq->qr=(double *)malloc(num*ncoef*sizeof(double));
+	pq->rdiag=(double *)malloc(ncoef*sizeof(double));
+	pq->beta=(double *)malloc(ncoef*sizeof(double));
+	pq->scale=(double *)malloc(ncoef*sizeof(double));
+	if (pq->qr == NULL || pq->rdiag == NULL || pq->beta == NULL || pq->scale == NULL)
+	{
+		polyFitFree(pq);
+		return -4;
+	}
 
-	Function return resistance in ohm.  If the values are outside the valid range, function returns 0 ohm
+	/* columns x^jj (or x^-jj), scaled to a largest value of 1 */
+	for (ii=0;ii<num;ii++)
+	{
+		val=(order < 0) ? 1.0/xdata[ii] : xdata[ii];
+		pq->qr[ii]=1.0;
+		for (jj=1;jj<ncoef;jj++) pq->qr[jj*num+ii]=pq->qr[(jj-1)*num+ii]*val;
+	}
+	for (jj=0;jj<ncoef;jj++)
+	{
+		col=pq->qr + jj*num;
+		pq->scale[jj]=0.0;
+		for (ii=0;ii<num;ii++) if (fabs(col[ii]) > pq->scale[jj]) pq->scale[jj]=fabs(col[ii]);
+		if (pq->scale[jj] == 0.0)
+		{
+			polyFitFree(pq);
+			return -3;
+		}
+		for (ii=0;ii<num;ii++) col[ii]=col[ii]/pq->scale[jj];
+	}
 
-*/
-/********************************************************************************************/
-#ifdef _HPUX_SOURCE
-	double rtd_PT500A385_FtoOhm (double tempInDegF)
-#else
-	DllExport double __cdecl rtd_PT500A385_FtoOhm (double tempInDegF)
-#endif
-{
-   double ohm;  
+	/* Householder QR */
+	maxDiag=0.0;
+	for (jj=0;jj<ncoef;jj++)
+	{
+		vv=pq->qr + jj*num;
 
-   if (tempInDegF == 32.0) return 500.0;
+		norm=0.0;
+		for (ii=jj;ii<num;ii++) norm=norm + vv[ii]*vv[ii];
+		norm=sqrt(norm);
 
-//   ohm=rtd_PTgenA385_FtoOhm2 (tempInDegF, 500.0);
-   ohm=rtd_PTgen_FtoOhm (tempInDegF, 500.0, 0.0, 0.0, 0.0);	// Nuri Cankurt 9-29-2008
+		alpha=(vv[jj] >= 0.0) ? -norm : norm;
+		pq->rdiag[jj]=alpha;
+		if (fabs(alpha) > maxDiag) maxDiag=fabs(alpha);
+		if (norm == 0.0 || fabs(alpha) <= 1.0e-14*maxDiag*sqrt((double)num))
+		{
+			polyFitFree(pq);
+			return -3;
+		}
 
-   return ohm;
+		vv[jj]=vv[jj] - alpha;
+		pq->beta[jj]=1.0/(-alpha*vv[jj]);		/* 2/(v.v) */
+
+		for (cc=jj+1;cc<ncoef;cc++)
+		{
+			col=pq->qr + cc*num;
+			ss=0.0;
+			for (ii=jj;ii<num;ii++) ss=ss + vv[ii]*col[ii];
+			ss=ss*pq->beta[jj];
+			for (ii=jj;ii<num;ii++) col[ii]=col[ii] - ss*vv[ii];
+		}
+	}
+
+	return 0;
 }
 
-/********************************************************************************************/
-/*
-	Written by: Nuri Cankurt March 10, 2004
+/* solves for one channel.  'work' (num values) is overwritten */
+static void polyFitSolve (polyFitQR *pq, double *ydata, double *work, double *coef)
+{
+	long ii, jj, cc, num;
+	double *vv;
+	double ss;
 
-	rtd_PT1000A385_FtoOhm: This function calculates resistance in ohm for 1000 ohm Platinum RTD
-	with Alpha coefficient of 0.00385
+	num=pq->num;
+	for (ii=0;ii<num;ii++) work[ii]=ydata[ii];
 
-    The equations are valid for -200 degC (-328 degF) to +850 degC (1562 degF)
+	for (jj=0;jj<pq->ncoef;jj++)
+	{
+		vv=pq->qr + jj*num;
+		ss=0.0;
+		for (ii=jj;ii<num;ii++) ss=ss + vv[ii]*work[ii];
+		ss=ss*pq->beta[jj];
+		for (ii=jj;ii<num;ii++) work[ii]=work[ii] - ss*vv[ii];
+	}
 
+	for (jj=pq->ncoef-1;jj>=0;jj--)
+	{
+		ss=work[jj];
+		for (cc=jj+1;cc<pq->ncoef;cc++) ss=ss - pq->qr[cc*num+jj]*coef[cc];
+		coef[jj]=ss/pq->rdiag[jj];
+	}
+	for (jj=0;jj<pq->ncoef;jj++) coef[jj]=coef[jj]/pq->scale[jj];
+}
 
-	Calling parameters:
+/* root mean square of the fit residuals, evaluated with polyValue */
+static double polyFitRms (double *coef, double *xdata, double *ydata, long num, long order)
+{
+	long ii;
+	double res, sum;
 
-	tempInDegF:		temperature in deg F
+	sum=0.0;
+	for (ii=0;ii<num;ii++)
+	{
+		res=ydata[ii] - polyValue(coef,xdata[ii],order);
+		sum=sum + res*res;
+	}
 
-	Function return resistance in ohm.  If the values are outside the valid range, function returns 0 ohm
+	return sqrt(sum/(double)num);
+}
 
-*/
-/********************************************************************************************/
+/********************************************************************************/
+/*																				*/
+/* polyFit: This function fits a polynomial to xdata and ydata by least square	*/
+/*	and returns its coefficients in the form used by polyValue					*/
+/*																				*/
+/*	xdata and ydata: Array of data sets											*/
+/*	num: Number data points in xdata and ydata									*/
+/*  order:  Polynomial function order, as for polyValue							*/
+/*	if (order=0)Y=coef[0]														*/
+/*  if (order>0)Y=coef[0]+coef[1]*X+coef[2]*X^2 +..+coef[N]*X^N					*/
+/*  if (order<0)Y=coef[0]+coef[1]/X+coef[2]/X^2 +..+coef[N]/X^N					*/
+/*	coef: returned coefficients, |order|+1 values								*/
+/*	rms: returned root mean square of the residuals (may be NULL)				*/
+/*																				*/
+/*  Function returns 0 if no error, or the following error codes:				*/
+/*	-1 if num < |order|+1  (not enough data points)								*/
+/*	-2 if order < 0 and an X value is 0											*/
+/*	-3 if the points do not determine the polynomial (too few distinct X)		*/
+/*	-4 out of memory															*/
+/********************************************************************************/
 #ifdef _HPUX_SOURCE
-	double rtd_PT1000A385_FtoOhm (double tempInDegF)
+	long polyFit (double *xdata, double *ydata, long num, long order, double *coef, double *rms)
 #else
-	DllExport double __cdecl rtd_PT1000A385_FtoOhm (double tempInDegF)
+	DllExport long __cdecl polyFit (double *xdata, double *ydata, long num, long order, double *coef, double *rms)
 #endif
 {
-   double ohm;  /* deg F */
+	polyFitQR pq;
+	double *work;
+	long ii, result;
 
-   if (tempInDegF == 32.0) return 1000.0;
+	for (ii=0;ii<=labs(order);ii++)coef[ii]=0.0;
+	if (rms != NULL) *rms=0.0;
 
-//   ohm=rtd_PTgenA385_FtoOhm2 (tempInDegF, 1000.0);
-   ohm=rtd_PTgen_FtoOhm (tempInDegF, 1000.0, 0.0, 0.0, 0.0);	// Nuri Cankurt 9-29-2008
+	result=polyFitFactor(&pq,xdata,num,order);
+	if (result != 0)return result;
 
-   return ohm;
+	work=(double *)malloc(num*sizeof(double));
+	if (work == NULL)
+	{
+		polyFitFree(&pq);
+		return -4;
+	}
+
+	polyFitSolve(&pq,ydata,work,coef);
+	if (rms != NULL) *rms=polyFitRms(coef,xdata,ydata,num,order);
+
+	free(work);
+	polyFitFree(&pq);
+
+	return 0;
 }
 
 /********************************************************************************/
 /*																				*/
-/* polyValue: This function returns result of a polynomial equation				*/
+/* polyFit_multi: This function performs polyFit for 'numY' channels against	*/
+/*	the same xdata.  The QR factorization of xdata is done once.				*/
 /*																				*/
-/*	xval: X value for which polynomial function is calculated					*/
-/*  coef: Coeefients for polynomial function 0th, 1st, 2nd,.....Nth	order		*/
-/*  order:  Polynomial function order (i.e. 9 for 9th order polynomial			*/
-/*	if (order=0)polyValue=coef[0]												*/
-/*  if (order>0)polyValue=coef[0]+coef[1]*xval+coef[2]*xval^2 +..+coef[N]*xval^N*/
-/*  if (order<0)polyValue=coef[0]+coef[1]/xval+coef[2]/xval^2 +..+coef[N]/xval^N*/
+/*	xdata: Array of X values													*/
+/*	ydata: num x numY values, column major (channel k is ydata[k*num] to		*/
+/*		ydata[k*num+num-1])														*/
+/*	num: Number data points in xdata and in each channel						*/
+/*	numY: Number of channels													*/
+/*  order:  Polynomial function order, as for polyFit							*/
+/*	coef: returned coefficients, |order|+1 values per channel (channel k		*/
+/*		starts at coef[k*(|order|+1)])											*/
+/*	rms: returned root mean square of the residuals of each channel				*/
+/*		(may be NULL)															*/
+/*																				*/
+/*  Function returns 0 if no error, or the error codes of polyFit				*/
 /********************************************************************************/
 #ifdef _HPUX_SOURCE
-	double polyValue (double *coef, double xval, long order)
+	long polyFit_multi (double *xdata, double *ydata, long num, long numY, long order, double *coef, double *rms)
 #else
-	DllExport double __cdecl polyValue (double *coef, double xval, long order)
+	DllExport long __cdecl polyFit_multi (double *xdata, double *ydata, long num, long numY, long order, double *coef, double *rms)
 #endif
 {
-	long	orderUsed;
-	long	ii;
-	double	result;	
-	double	lastFactor;
-	double	factor;
+	polyFitQR pq;
+	double *work;
+	long ii, ch, ncoef, result;
 
-	orderUsed=order;
+	ncoef=labs(order) + 1;
+	for (ii=0;ii<numY*ncoef;ii++)coef[ii]=0.0;
+	if (rms != NULL) for (ch=0;ch<numY;ch++)rms[ch]=0.0;
 
-	if (order == 0)
-	{
-		return coef[0];
-	}
-	else
-	if (order > 0)
-	{
-		if (xval == 0.0)return coef[0];
-	}
-	else
-	if (order < 0)
-	{
-		if (xval == 0.0)return 0.0; /* error */
-		orderUsed=(-1)*order;
-	}
+	if (numY < 1)return -1;
 
-	result=coef[0];
-	lastFactor=1.0;
+	result=polyFitFactor(&pq,xdata,num,order);
+	if (result != 0)return result;
 
-	if (order > 0)
+	work=(double *)malloc(num*sizeof(double));
+	if (work == NULL)
 	{
-		for (ii=1;ii<=orderUsed;ii++)
-		{
-			factor=lastFactor*xval;
-			result=result + coef[ii]*factor;
-			lastFactor=factor;
-		}
+		polyFitFree(&pq);
+		return -4;
 	}
-	else
-	if (order < 0)
+
+	for (ch=0;ch<numY;ch++)
 	{
-		for (ii=1;ii<=orderUsed;ii++)
-		{
-			factor=lastFactor*xval;
-			result=result + coef[ii]/factor;
-			lastFactor=factor;
-		}
+		polyFitSolve(&pq,ydata+ch*num,work,coef+ch*ncoef);
+		if (rms != NULL) rms[ch]=polyFitRms(coef+ch*ncoef,xdata,ydata+ch*num,num,order);
 	}
 
-	return result;
+	free(work);
+	polyFitFree(&pq);
+
+	return 0;
 }
 
 /********************************************************************************/
@@ -3712,4 +9979,147 @@ long error;
 	free(sortedIndex);
 
 	return -5;
-}
\ No newline at end of file
+}
+
+/********************************************************************************/
+/*																				*/
+/* resampleChannels: This function resamples channels that were recorded with	*/
+/*	their own (irregular) DDDHHMMSSsss timestamps onto one uniform time grid,	*/
+/*	so all channels line up sample by sample.									*/
+/*																				*/
+/*	timeData: array of numChannels pointers to timestamp arrays (DDDHHMMSSsss)	*/
+/*	valueData: array of numChannels pointers to value arrays					*/
+/*	numData: array of numChannels sample counts									*/
+/*	numChannels: number of channels												*/
+/*	startTime: first grid time as DDDHHMMSSsss									*/
+/*	stepSec: grid step in seconds												*/
+/*	numGrid: number of grid points												*/
+/*	how: 'l' for linear interpolation (same formula as linearLookup)			*/
+/*		 'p' for previous value (sample and hold)								*/
+/*	fillValue: value used where a channel has no data for a grid point			*/
+/*		(before its first sample, and after its last sample for 'l')			*/
+/*	outData: array of numChannels pointers to arrays of numGrid values			*/
+/*																				*/
+/*  Timestamps are decoded once and year rollovers are removed, so the grid		*/
+/*  may cross the end of the year.  Each channel is then merged with the grid	*/
+/*  in one walk.  Channels that are not in time order are sorted first			*/
+/*  (sortDoubleAdaptive, fast for a few late samples).							*/
+/*																				*/
+/*  Function returns 0 if no error, or the following error codes:				*/
+/*	-1 if numChannels < 1, numGrid < 1, stepSec <= 0 or 'how' is unknown		*/
+/*	-2 if a channel has no data (its output is set to fillValue)				*/
+/*	-3 out of memory															*/
+/********************************************************************************/
+#ifdef _HPUX_SOURCE
+	long resampleChannels (double **timeData, double **valueData, long *numData, long numChannels, double startTime, double stepSec, long numGrid, char how, double fillValue, double **outData)
+#else
+	DllExport long __cdecl resampleChannels (double **timeData, double **valueData, long *numData, long numChannels, double startTime, double stepSec, long numGrid, char how, double fillValue, double **outData)
+#endif
+{
+	long	ch, ii, jj, kk, num, sorted, startDay, result;
+	long	*sortedIndex;
+	double	*chanTime;
+	double	*yy;
+	double	gridStart, gridTime, yearLen, x1, x2, y1, y2;
+	char	chow;
+	timeUnwrapper tu;
+
+	chow=how;
+	if (chow == 'L')chow='l';
+	if (chow == 'P')chow='p';
+	if (numChannels < 1 || numGrid < 1 || stepSec <= 0.0)return -1;
+	if (chow != 'l' && chow != 'p')return -1;
+
+	gridStart=timeToYearMillisec(startTime,&startDay)/1000.0;
+	yearLen=(startDay >= 366) ? 366.0*86400.0 : 365.0*86400.0;
+	if (startDay < 1) yearLen=86400.0;
+
+	result=0;
+	for (ch=0;ch<numChannels;ch++)
+	{
+		num=numData[ch];
+		yy=valueData[ch];
+
+		if (num < 1)
+		{
+			for (kk=0;kk<numGrid;kk++)outData[ch][kk]=fillValue;
+			result=-2;
+			continue;
+		}
+
+		chanTime=(double *)malloc(num*sizeof(double));
+		sortedIndex=(long *)malloc(num*sizeof(long));
+		if (chanTime == NULL || sortedIndex == NULL)
+		{
+			free(chanTime);
+			free(sortedIndex);
+			return -3;
+		}
+
+		/* decode once; a channel that starts on the other side of a rollover
+		   from startTime is moved by one year (day) to the grid's axis */
+		timeUnwrapInit(&tu);
+		sorted=1;
+		for (ii=0;ii<num;ii++)
+		{
+			chanTime[ii]=timeUnwrapNext(&tu,timeData[ch][ii]);
+			if (ii > 0 && chanTime[ii] < chanTime[ii-1]) sorted=0;
+		}
+		if (chanTime[0] < gridStart - yearLen/2.0)
+		{
+			for (ii=0;ii<num;ii++)chanTime[ii]=chanTime[ii] + yearLen;
+		}
+		else if (chanTime[0] > gridStart + yearLen/2.0)
+		{
+			for (ii=0;ii<num;ii++)chanTime[ii]=chanTime[ii] - yearLen;
+		}
+
+		if (sorted)
+		{
+			for (ii=0;ii<num;ii++)sortedIndex[ii]=ii;
+		}
+		else if (sortDoubleAdaptive(chanTime,num,'a',sortedIndex) != 0)
+		{
+			free(chanTime);
+			free(sortedIndex);
+			return -3;
+		}
+
+		/* jj is the last sample at or before the grid time, -1 if none */
+		jj=-1;
+		for (kk=0;kk<numGrid;kk++)
+		{
+			gridTime=gridStart + (double)kk*stepSec;
+			while (jj+1 < num && chanTime[sortedIndex[jj+1]] <= gridTime) jj++;
+
+			if (jj < 0)
+			{
+				outData[ch][kk]=fillValue;
+			}
+			else if (chow == 'p')
+			{
+				outData[ch][kk]=yy[sortedIndex[jj]];
+			}
+			else if (jj == num-1)
+			{
+				if (chanTime[sortedIndex[jj]] == gridTime) outData[ch][kk]=yy[sortedIndex[jj]];
+				else outData[ch][kk]=fillValue;
+			}
+			else
+			{
+				x1=chanTime[sortedIndex[jj]];
+				y1=yy[sortedIndex[jj]];
+
+				x2=chanTime[sortedIndex[jj+1]];
+				y2=yy[sortedIndex[jj+1]];
+
+				outData[ch][kk]=((gridTime-x1)/(x2-x1))*(y2-y1) + y1;
+			}
+		}
+
+		free(chanTime);
+		free(sortedIndex);
+	}
+
+	return result;
+}